@@ -0,0 +1,127 @@
+/**
+ * @file fen_bench.cpp
+ * @brief Measures FEN and packed position encoding throughput.
+ * Builds a set of positions by expanding a few well-known FENs two plies deep,
+ * checks that every position round-trips through both encodings, then times
+ * Board::loadFromFen, Board::toFen, Board::decode and Board::encode over the
+ * whole set.
+ */
+#include "../include/movegen.hpp"
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+static const char *seedFens[] = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+    "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+    "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+};
+
+// Collects the FEN of every position reachable within 'depth' plies
+static void collectFens(Board &board, int depth,
+                        std::vector<std::string> &out) {
+  char fen[MAX_FEN_LENGTH];
+  board.toFen(fen);
+  out.emplace_back(fen);
+  if (depth == 0)
+    return;
+
+  std::vector<Move> moves =
+      MoveGeneration::generateAllMoves(board, board.getWhiteToMove());
+  for (const Move &move : moves) {
+    board.makeMove(move);
+    collectFens(board, depth - 1, out);
+    board.undoMove();
+  }
+}
+
+int main() {
+  std::vector<std::string> fens;
+  for (const char *seed : seedFens) {
+    Board board(seed);
+    collectFens(board, 2, fens);
+  }
+
+  // Every position must survive a round trip through both encodings
+  Board board;
+  char buffer[MAX_FEN_LENGTH];
+  std::vector<Position> positions;
+  std::vector<PackedPosition> packedPositions;
+  for (const std::string &fen : fens) {
+    board.loadFromFen(fen);
+    positions.push_back(board.getPosition());
+    u64 hash = board.getZobristHash();
+    board.toFen(buffer);
+    if (fen != buffer) {
+      std::cout << "Round trip mismatch:\n  " << fen << "\n  " << buffer
+                << std::endl;
+      return 1;
+    }
+
+    PackedPosition packed = board.encode();
+    board.decode(packed);
+    if (board.getZobristHash() != hash || !(board.encode() == packed)) {
+      std::cout << "Packed round trip mismatch: " << fen << std::endl;
+      return 1;
+    }
+    packedPositions.push_back(packed);
+  }
+
+  const int ROUNDS = 200;
+  u64 lines = static_cast<u64>(fens.size()) * ROUNDS;
+  u64 checksum = 0;
+
+  auto start = std::chrono::high_resolution_clock::now();
+  for (int round = 0; round < ROUNDS; round++) {
+    for (const std::string &fen : fens) {
+      board.loadFromFen(fen);
+      checksum ^= board.getZobristHash();
+    }
+  }
+  auto mid = std::chrono::high_resolution_clock::now();
+  for (int round = 0; round < ROUNDS; round++) {
+    for (const Position &position : positions) {
+      checksum += position.toFen(buffer);
+    }
+  }
+  auto end = std::chrono::high_resolution_clock::now();
+
+  auto packedStart = std::chrono::high_resolution_clock::now();
+  for (int round = 0; round < ROUNDS; round++) {
+    for (const PackedPosition &packed : packedPositions) {
+      board.decode(packed);
+      checksum ^= board.getZobristHash();
+    }
+  }
+  auto packedMid = std::chrono::high_resolution_clock::now();
+  for (int round = 0; round < ROUNDS; round++) {
+    for (const Position &position : positions) {
+      checksum += position.encode().hash();
+    }
+  }
+  auto packedEnd = std::chrono::high_resolution_clock::now();
+
+  double parseSeconds = std::chrono::duration<double>(mid - start).count();
+  double writeSeconds = std::chrono::duration<double>(end - mid).count();
+  double decodeSeconds =
+      std::chrono::duration<double>(packedMid - packedStart).count();
+  double encodeSeconds =
+      std::chrono::duration<double>(packedEnd - packedMid).count();
+
+  std::cout << "Positions: " << fens.size() << " x " << ROUNDS << " rounds"
+            << std::endl;
+  std::cout << "loadFromFen: " << static_cast<u64>(lines / parseSeconds)
+            << " FENs/s" << std::endl;
+  std::cout << "toFen:       " << static_cast<u64>(lines / writeSeconds)
+            << " FENs/s" << std::endl;
+  std::cout << "decode:      " << static_cast<u64>(lines / decodeSeconds)
+            << " positions/s" << std::endl;
+  std::cout << "encode:      " << static_cast<u64>(lines / encodeSeconds)
+            << " positions/s" << std::endl;
+  std::cout << "(checksum " << checksum << ")" << std::endl;
+  return 0;
+}
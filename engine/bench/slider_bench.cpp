@@ -0,0 +1,122 @@
+/**
+ * @file slider_bench.cpp
+ * @brief Measures the slider attack backend selected at build time.
+ * Times per-piece slider lookups through the Magic:: backend, the whole-side
+ * slider fill and validMoveBB::allEnemyAttacks over a set of positions, and
+ * runs perft on a few reference positions. The slider_bench and
+ * slider_bench_pext targets build this file with the magic and PEXT backends;
+ * the per-piece lookup figure is the one that compares them, since the fill
+ * and allEnemyAttacks use AVX2 instead when the CPU has it.
+ */
+#include "../include/magic.hpp"
+#include "../include/perft.hpp"
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+static const char *seedFens[] = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+    "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+    "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+};
+
+static const int perftDepths[] = {5, 4, 5, 4, 4, 4};
+
+// Walks the game tree 'depth' plies deep and keeps every node
+static void collectPositions(Board &board, int depth,
+                             std::vector<Position> &out) {
+  out.push_back(board.getPosition());
+  if (depth == 0)
+    return;
+
+  MoveList moves;
+  MoveGeneration::generateAllMoves(board, board.getWhiteToMove(), moves);
+  for (Move move : moves) {
+    board.makeMove(move);
+    collectPositions(board, depth - 1, out);
+    board.undoMove();
+  }
+}
+
+int main() {
+  std::cout << "Slider backend: " << Magic::BACKEND << std::endl;
+  std::cout << "Slider fill:    "
+            << (validMoveBB::hasAvx2SliderAttacks() ? "avx2" : "scalar")
+            << std::endl;
+
+  std::vector<Position> positions;
+  for (const char *seed : seedFens) {
+    Board board(seed);
+    collectPositions(board, 2, positions);
+  }
+  std::vector<Board> boards(positions.begin(), positions.end());
+
+  const int ROUNDS = 200;
+  u64 calls = static_cast<u64>(boards.size()) * ROUNDS * 2;
+  u64 checksum = 0;
+
+  // Per-piece lookups through the configured Magic:: backend only
+  auto start = std::chrono::high_resolution_clock::now();
+  for (int round = 0; round < ROUNDS; round++) {
+    for (Board &board : boards) {
+      u64 occupied = board.getAllPieces();
+      for (Color color : {WHITE, BLACK}) {
+        u64 queens = board.getPieces(color, QUEEN);
+        checksum += validMoveBB::sliderAttacksScalar(
+            board.getPieces(color, BISHOP) | queens,
+            board.getPieces(color, ROOK) | queens, occupied);
+      }
+    }
+  }
+  auto end = std::chrono::high_resolution_clock::now();
+  double lookupSeconds = std::chrono::duration<double>(end - start).count();
+
+  // The same slider sets through the dispatched fill
+  start = std::chrono::high_resolution_clock::now();
+  for (int round = 0; round < ROUNDS; round++) {
+    for (Board &board : boards) {
+      u64 occupied = board.getAllPieces();
+      for (Color color : {WHITE, BLACK}) {
+        u64 queens = board.getPieces(color, QUEEN);
+        checksum ^= validMoveBB::sliderAttacks(
+            board.getPieces(color, BISHOP) | queens,
+            board.getPieces(color, ROOK) | queens, occupied);
+      }
+    }
+  }
+  end = std::chrono::high_resolution_clock::now();
+  double fillSeconds = std::chrono::duration<double>(end - start).count();
+
+  start = std::chrono::high_resolution_clock::now();
+  for (int round = 0; round < ROUNDS; round++) {
+    for (Board &board : boards) {
+      checksum ^= validMoveBB::allEnemyAttacks(board, true);
+      checksum += validMoveBB::allEnemyAttacks(board, false);
+    }
+  }
+  end = std::chrono::high_resolution_clock::now();
+  double attackSeconds = std::chrono::duration<double>(end - start).count();
+
+  u64 nodes = 0;
+  start = std::chrono::high_resolution_clock::now();
+  for (size_t i = 0; i < sizeof(seedFens) / sizeof(seedFens[0]); i++) {
+    Board board(seedFens[i]);
+    nodes += Perft::perft(board, perftDepths[i]);
+  }
+  end = std::chrono::high_resolution_clock::now();
+  double perftSeconds = std::chrono::duration<double>(end - start).count();
+
+  std::cout << "slider lookups:  " << static_cast<u64>(calls / lookupSeconds)
+            << " sides/s" << std::endl;
+  std::cout << "slider fill:     " << static_cast<u64>(calls / fillSeconds)
+            << " sides/s" << std::endl;
+  std::cout << "allEnemyAttacks: " << static_cast<u64>(calls / attackSeconds)
+            << " calls/s over " << boards.size() << " positions" << std::endl;
+  std::cout << "perft:           " << static_cast<u64>(nodes / perftSeconds)
+            << " nodes/s (" << nodes << " nodes)" << std::endl;
+  std::cout << "(checksum " << checksum << ")" << std::endl;
+  return 0;
+}
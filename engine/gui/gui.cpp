@@ -2,7 +2,6 @@
 
 #include "../include/ai.hpp"
 #include "../include/evaluation.hpp"
-#include "../include/magic.hpp"
 #include "../include/movegen.hpp"
 #include "../include/utils.hpp"
 #include <SFML/Graphics.hpp>
@@ -239,8 +238,7 @@ private:
 
     if (selectedSquareIndex == -1) {
       // Check what piece is at this square
-      PieceType piece =
-          Utils::getPieceTypeAt(board, Utils::makeSquare(rank, file));
+      PieceType piece = board.pieceOn(Utils::makeSquare(rank, file));
 
       if (piece != EMPTY && isCorrectColorPiece(piece)) {
         selectSquare(squareIndex);
@@ -371,6 +369,8 @@ private:
   }
 
   void undoMove() {
+    if (board.getHistoryPly() == 0)
+      return;
     board.undoMove();
     showingPromotionDialog = false;
     promotionMoves.clear(); // Clear promotion moves when undoing
@@ -491,8 +491,7 @@ private:
   void drawPieces() {
     for (int chessRank = 0; chessRank < 8; chessRank++) {
       for (int file = 0; file < 8; file++) {
-        PieceType piece =
-            Utils::getPieceTypeAt(board, Utils::makeSquare(chessRank, file));
+        PieceType piece = board.pieceOn(Utils::makeSquare(chessRank, file));
 
         if (piece != EMPTY) {
           sf::Sprite sprite(pieceTextures[piece]);
@@ -515,7 +514,6 @@ private:
 };
 
 int main() {
-  Magic::initMagics();
   ChessGUI gui;
   gui.run();
   return 0;
@@ -14,7 +14,20 @@
 
 class ChessAI {
 private:
+  static constexpr int MAX_PLY = 64;
+
   TranspositionTable tt; // Transposition table to cache board evaluations
+  int rootPly = 0;       // Board history ply at the root of the search
+  // Two quiet moves per ply that recently caused a beta cutoff
+  Move killers[MAX_PLY][2];
+  // Whether the first quiescence ply also searches quiet checks
+  bool quiescenceChecks = true;
+
+  // Returns the killer moves of a ply, or null outside the table
+  inline Move *killersAt(int ply) {
+    return ply >= 0 && ply < MAX_PLY ? killers[ply] : nullptr;
+  }
+  void storeKiller(int ply, Move move);
 
 public:
   ChessAI() : tt(64) {}
@@ -40,7 +53,8 @@ public:
   int quiescence(Board &board, int alpha, int beta, bool maximizingPlayer,
                  int qDepth = 0);
   // Generates only tactical moves like captures and promotions
-  std::vector<Move> generateTacticalMoves(Board &board);
+  void generateTacticalMoves(Board &board, MoveList &moves);
+  inline void setQuiescenceChecks(bool enabled) { quiescenceChecks = enabled; }
 };
 
 #endif
@@ -12,78 +12,244 @@
 #include "types.hpp"
 #include "zobrist.hpp"
 #include <cstdint>
+#include <cstring>
+#include <string_view>
 #include <sys/types.h>
+#include <type_traits>
 #include <vector>
 
 using u64 = uint64_t;
 
-// Stores information needed to undo a move
-struct undoInfo {
-  Move move;
-  PieceType capturedPiece;
-  Square enPassantSquare;
-  bool canWhiteCastleKS;
-  bool canWhiteCastleQS;
-  bool canBlackCastleKS;
-  bool canBlackCastleQS;
-  bool whiteToMove;
-  bool hasWhiteCastled;
-  bool hasBlackCastled;
+// Plies of history a Board keeps, plus headroom for a search on top. This is a
+// chosen cap, not a bound on game length: longer games drop their oldest
+// history (see Board::trimHistory and Board::makeMove).
+constexpr int MAX_GAME_PLY = 1024;
+constexpr int MAX_SEARCH_PLY = 128;
+constexpr int STATE_STACK_SIZE = MAX_GAME_PLY + MAX_SEARCH_PLY;
+
+// Buffer size that always fits a FEN written by Board::toFen, including the
+// terminating null character
+constexpr int MAX_FEN_LENGTH = 128;
+
+// Castling right bits, also used as the index into the Zobrist castle keys
+enum CastlingRights {
+  NO_CASTLING = 0,
+  WHITE_KS = 1,
+  WHITE_QS = 2,
+  BLACK_KS = 4,
+  BLACK_QS = 8,
+  ALL_CASTLING = 15
+};
+
+// Position state that cannot be recovered from the move alone. The current
+// state lives in the board; makeMove pushes a copy onto the state stack and
+// undoMove pops it back.
+struct StateInfo {
   u64 zobristHash;
+  u64 pawnKey;     // Zobrist key of the pawns only
+  u64 materialKey; // Key of the piece counts, independent of placement
+  Square enPassantSquare;
+  PieceType capturedPiece; // Piece captured by the move that led here
+  int castlingRights;
+  int halfmoveClock; // Plies since the last capture or pawn move
+  int pliesFromNull; // Plies since the last null move
+
+  // Check information, recomputed once per position by updateCheckInfo()
+  u64 checkers;           // Enemy pieces giving check to the side to move
+  u64 blockersForKing[2]; // Lone pieces (either color) shielding each king
+  u64 pinners[2];         // Sliders of each color pinning an enemy piece
+  u64 checkSquares[6];    // Squares where each piece kind would give check
 };
-class Board {
-private:
-  // Bitboards for each piece type and color
-  u64 whitePawns;
-  u64 whiteKnights;
-  u64 whiteBishops;
-  u64 whiteRooks;
-  u64 whiteQueens;
-  u64 whiteKing;
-  u64 blackPawns;
-  u64 blackKnights;
-  u64 blackBishops;
-  u64 blackRooks;
-  u64 blackQueens;
-  u64 blackKing;
+
+struct PackedPosition;
+
+// Everything that describes the current position: piece placement, the
+// current state and the side to move. It holds no pointers and no history,
+// so a position can be cloned with a single memcpy and handed to another
+// thread without sharing anything.
+struct Position {
+  // Bitboards for each color and piece kind
+  u64 pieces[2][6] = {};
 
   // Aggregate bitboards for all pieces of a color and all pieces on the board
-  u64 allWhitePieces;
-  u64 allBlackPieces;
-  u64 allPieces;
+  u64 occupancy[2] = {};
+  u64 allPieces = 0ULL;
 
-  std::vector<undoInfo>
-      stateHistory;              // History of board states for undoing moves
-  std::vector<Move> moveHistory; // History of moves made
+  // Piece on each square, kept in sync with the bitboards for O(1) lookups
+  PieceType board[64] = {};
 
   // Game state variables
-  bool canWhiteCastleKS = true;
-  bool canWhiteCastleQS = true;
-  bool canBlackCastleKS = true;
-  bool canBlackCastleQS = true;
-  Square enPassantSquare = SQ_NONE;
+  StateInfo st = {0ULL, 0ULL, 0ULL, SQ_NONE, EMPTY, ALL_CASTLING,
+                  0,    0,    0ULL, {},      {},    {}};
   bool whiteToMove = true;
 
   bool hasWhiteCastled = false;
   bool hasBlackCastled = false;
 
+  int gamePly = 0; // Plies since the start of the game, for the move number
+
+  inline int getFullmoveNumber() const { return 1 + gamePly / 2; }
+
+  // Writes the position as a null-terminated FEN string into 'out', which
+  // must hold at least MAX_FEN_LENGTH characters. Returns the FEN length.
+  int toFen(char *out) const;
+  // Packs the position into 32 bytes
+  PackedPosition encode() const;
+};
+
+static_assert(std::is_trivially_copyable<Position>::value,
+              "Position must stay trivially copyable");
+
+// Position packed into 32 bytes: the occupied squares, then a 4-bit PieceType
+// for each occupied square in ascending square order. Unused bytes are zero,
+// so packed positions can be compared and hashed byte for byte.
+struct PackedPosition {
+  u64 occupied;
+  uint8_t pieceCodes[16]; // Two pieces per byte, low nibble first
+  uint8_t whiteToMove;
+  uint8_t castlingRights;
+  uint8_t enPassantFile; // 0-7, or 8 when there is no en passant square
+  uint8_t halfmoveClock;
+  uint16_t fullmoveNumber;
+  uint8_t padding[2];
+
+  inline bool operator==(const PackedPosition &other) const {
+    return std::memcmp(this, &other, sizeof(PackedPosition)) == 0;
+  }
+
+  // Mixes the four 64-bit words of the encoding into one hash
+  inline u64 hash() const {
+    u64 words[4];
+    std::memcpy(words, this, sizeof(words));
+    u64 h = 0ULL;
+    for (u64 word : words) {
+      h = (h ^ word) * 0x9E3779B97F4A7C15ULL;
+      h ^= h >> 29;
+    }
+    return h;
+  }
+};
+
+static_assert(sizeof(PackedPosition) == 32, "PackedPosition must be 32 bytes");
+
+// Hasher for using packed positions as unordered container keys
+struct PackedPositionHash {
+  inline size_t operator()(const PackedPosition &packed) const {
+    return static_cast<size_t>(packed.hash());
+  }
+};
+
+class Board : private Position {
+private:
+  // Preallocated history of previous states and the moves made from them
+  StateInfo stateStack[STATE_STACK_SIZE];
+  Move moveStack[STATE_STACK_SIZE];
+  int historyPly = 0;
+
+  // Keeps only the newest 'keep' plies of history
+  void dropOldHistory(int keep);
+
   static Zobrist zobrist; // Zobrist hashing keys
-  u64 zobristHash;        // Current board's Zobrist hash
+
+  // Writes the squares that differ between the old and new bitboard of a piece
+  // type into the mailbox. Squares already taken over by another piece are
+  // left alone, so the setters can be called in any order.
+  inline void updateMailbox(PieceType piece, u64 oldBB, u64 newBB) {
+    u64 removed = oldBB & ~newBB;
+    u64 added = newBB & ~oldBB;
+    while (removed) {
+      int sq = __builtin_ctzll(removed);
+      if (board[sq] == piece)
+        board[sq] = EMPTY;
+      removed &= removed - 1;
+    }
+    while (added) {
+      board[__builtin_ctzll(added)] = piece;
+      added &= added - 1;
+    }
+  }
+
+  // Replaces the whole bitboard of a piece; aggregates are refreshed by
+  // setALLPiecesAggregate()
+  inline void setPieces(PieceType piece, u64 value) {
+    u64 &bb = pieces[colorOf(piece)][kindOf(piece)];
+    updateMailbox(piece, bb, value);
+    bb = value;
+  }
+
+  // Incremental updates used by makeMove/undoMove. Each keeps the piece
+  // bitboards, the aggregates and the mailbox in sync with a few XORs.
+  inline void putPiece(PieceType piece, Square sq) {
+    u64 bit = 1ULL << sq;
+    Color color = colorOf(piece);
+    pieces[color][kindOf(piece)] ^= bit;
+    occupancy[color] ^= bit;
+    allPieces ^= bit;
+    board[sq] = piece;
+  }
+
+  inline void removePiece(Square sq) {
+    PieceType piece = board[sq];
+    u64 bit = 1ULL << sq;
+    Color color = colorOf(piece);
+    pieces[color][kindOf(piece)] ^= bit;
+    occupancy[color] ^= bit;
+    allPieces ^= bit;
+    board[sq] = EMPTY;
+  }
+
+  inline void movePiece(PieceType piece, Square from, Square to) {
+    u64 fromTo = (1ULL << from) | (1ULL << to);
+    Color color = colorOf(piece);
+    pieces[color][kindOf(piece)] ^= fromTo;
+    occupancy[color] ^= fromTo;
+    allPieces ^= fromTo;
+    board[from] = EMPTY;
+    board[to] = piece;
+  }
+
+  // Recomputes the cached checkers, king blockers, pinners and check squares
+  void updateCheckInfo();
+  template <Color Us> void updateCheckInfo();
+  // Recomputes only the check squares of the side to move
+  void updateCheckSquares();
+  template <Color Us> void updateCheckSquares();
 
 public:
   Board();
   Board(u64 wPawns, u64 bPawns, u64 wKnights, u64 bKnights, u64 wBishops,
         u64 bBishops, u64 wRooks, u64 bRooks, u64 wQueens, u64 bQueens,
         u64 wKing, u64 bKing);
-  Board(const std::string &fen);
+  Board(std::string_view fen);
+  // Starts from a copied position with an empty move history
+  explicit Board(const Position &position);
+  Board(const Board &other);
   ~Board() = default;
 
+  // Copies the position and the move history
   Board &operator=(const Board &other);
 
+  // The position without its history, for cloning into worker threads
+  inline const Position &getPosition() const { return *this; }
+
   // Applies a move to the board
   void makeMove(const Move &move);
   // Reverts the last move made
   void undoMove();
+  // Drops the oldest history once a game passes MAX_GAME_PLY, so that a
+  // search of up to MAX_SEARCH_PLY plies fits on the stack
+  void trimHistory();
+
+  // Passes the turn without moving a piece. Must not be used while in check.
+  void makeNullMove();
+  // Reverts the last null move
+  void undoNullMove();
+
+  // Checks for a draw by the fifty-move rule or by repetition. A position
+  // repeated within the last 'ply' plies (the current search) counts at once;
+  // earlier history needs a threefold repetition. Checkmate takes precedence
+  // over the fifty-move rule.
+  bool isDraw(int ply);
 
   // Checks if the king of the specified color is in check
   bool isKingChecked(bool isWhite);
@@ -91,107 +257,180 @@ public:
   // Counts the number of pieces attacking the king
   int getAttackersCount(bool isWhite);
 
+  // Returns the pieces of both colors attacking 'sq' under the given
+  // occupancy. Intersect with getOccupancy(color) for one side's attackers.
+  u64 attackersTo(Square sq, u64 occupied) const;
+
   // Loads a board position from a FEN string
-  void loadFromFen(const std::string &fen);
+  void loadFromFen(std::string_view fen);
+  using Position::toFen;
+
+  // Packs the position into 32 bytes, and loads a packed position back
+  using Position::encode;
+  void decode(const PackedPosition &packed);
 
   // Castling availability checks
   bool canCastleKingSide(bool isWhite);
   bool canCastleQueenSide(bool isWhite);
 
   // --- Getters and Setters for piece bitboards ---
-  inline u64 getWhitePawns() const { return whitePawns; }
-  inline u64 getBlackPawns() const { return blackPawns; }
+  inline u64 getPieces(Color color, PieceKind kind) const {
+    return pieces[color][kind];
+  }
+  inline u64 getPieces(PieceType piece) const {
+    return pieces[colorOf(piece)][kindOf(piece)];
+  }
 
-  inline void setWhitePawns() { whitePawns = 0x000000000000FF00ULL; }
-  inline void setWhitePawns(u64 value) { whitePawns = value; }
+  inline u64 getWhitePawns() const { return pieces[WHITE][PAWN]; }
+  inline u64 getBlackPawns() const { return pieces[BLACK][PAWN]; }
 
-  inline void setBlackPawns() { blackPawns = 0x00FF000000000000ULL; }
-  inline void setBlackPawns(u64 value) { blackPawns = value; }
+  inline void setWhitePawns() { setWhitePawns(0x000000000000FF00ULL); }
+  inline void setWhitePawns(u64 value) { setPieces(WHITE_PAWN, value); }
 
-  inline u64 getWhiteKnights() const { return whiteKnights; }
-  inline u64 getBlackKnights() const { return blackKnights; }
+  inline void setBlackPawns() { setBlackPawns(0x00FF000000000000ULL); }
+  inline void setBlackPawns(u64 value) { setPieces(BLACK_PAWN, value); }
 
-  inline void setWhiteKnights() { whiteKnights = 0x0000000000000042ULL; }
-  inline void setWhiteKnights(u64 value) { whiteKnights = value; }
+  inline u64 getWhiteKnights() const { return pieces[WHITE][KNIGHT]; }
+  inline u64 getBlackKnights() const { return pieces[BLACK][KNIGHT]; }
 
-  inline void setBlackKnights() { blackKnights = 0x4200000000000000ULL; }
-  inline void setBlackKnights(u64 value) { blackKnights = value; }
+  inline void setWhiteKnights() { setWhiteKnights(0x0000000000000042ULL); }
+  inline void setWhiteKnights(u64 value) { setPieces(WHITE_KNIGHT, value); }
 
-  inline u64 getWhiteBishops() const { return whiteBishops; }
-  inline u64 getBlackBishops() const { return blackBishops; }
+  inline void setBlackKnights() { setBlackKnights(0x4200000000000000ULL); }
+  inline void setBlackKnights(u64 value) { setPieces(BLACK_KNIGHT, value); }
 
-  inline void setWhiteBishops() { whiteBishops = 0x0000000000000024ULL; }
-  inline void setWhiteBishops(u64 value) { whiteBishops = value; }
+  inline u64 getWhiteBishops() const { return pieces[WHITE][BISHOP]; }
+  inline u64 getBlackBishops() const { return pieces[BLACK][BISHOP]; }
 
-  inline void setBlackBishops() { blackBishops = 0x2400000000000000ULL; }
-  inline void setBlackBishops(u64 value) { blackBishops = value; }
+  inline void setWhiteBishops() { setWhiteBishops(0x0000000000000024ULL); }
+  inline void setWhiteBishops(u64 value) { setPieces(WHITE_BISHOP, value); }
 
-  inline u64 getWhiteRooks() const { return whiteRooks; }
-  inline u64 getBlackRooks() const { return blackRooks; }
+  inline void setBlackBishops() { setBlackBishops(0x2400000000000000ULL); }
+  inline void setBlackBishops(u64 value) { setPieces(BLACK_BISHOP, value); }
 
-  inline void setWhiteRooks() { whiteRooks = 0x0000000000000081ULL; }
-  inline void setWhiteRooks(u64 value) { whiteRooks = value; }
+  inline u64 getWhiteRooks() const { return pieces[WHITE][ROOK]; }
+  inline u64 getBlackRooks() const { return pieces[BLACK][ROOK]; }
 
-  inline void setBlackRooks() { blackRooks = 0x8100000000000000ULL; }
-  inline void setBlackRooks(u64 value) { blackRooks = value; }
+  inline void setWhiteRooks() { setWhiteRooks(0x0000000000000081ULL); }
+  inline void setWhiteRooks(u64 value) { setPieces(WHITE_ROOK, value); }
 
-  inline u64 getWhiteQueens() const { return whiteQueens; }
-  inline u64 getBlackQueens() const { return blackQueens; }
+  inline void setBlackRooks() { setBlackRooks(0x8100000000000000ULL); }
+  inline void setBlackRooks(u64 value) { setPieces(BLACK_ROOK, value); }
 
-  inline void setWhiteQueens() { whiteQueens = 0x0000000000000008ULL; }
-  inline void setWhiteQueens(u64 value) { whiteQueens = value; }
+  inline u64 getWhiteQueens() const { return pieces[WHITE][QUEEN]; }
+  inline u64 getBlackQueens() const { return pieces[BLACK][QUEEN]; }
 
-  inline void setBlackQueens() { blackQueens = 0x0800000000000000ULL; }
-  inline void setBlackQueens(u64 value) { blackQueens = value; }
+  inline void setWhiteQueens() { setWhiteQueens(0x0000000000000008ULL); }
+  inline void setWhiteQueens(u64 value) { setPieces(WHITE_QUEEN, value); }
 
-  inline u64 getWhiteKing() const { return whiteKing; }
-  inline u64 getBlackKing() const { return blackKing; }
+  inline void setBlackQueens() { setBlackQueens(0x0800000000000000ULL); }
+  inline void setBlackQueens(u64 value) { setPieces(BLACK_QUEEN, value); }
 
-  inline void setWhiteKing() { whiteKing = 0x0000000000000010ULL; }
-  inline void setWhiteKing(u64 value) { whiteKing = value; }
+  inline u64 getWhiteKing() const { return pieces[WHITE][KING]; }
+  inline u64 getBlackKing() const { return pieces[BLACK][KING]; }
 
-  inline void setBlackKing() { blackKing = 0x1000000000000000ULL; }
-  inline void setBlackKing(u64 value) { blackKing = value; }
+  inline void setWhiteKing() { setWhiteKing(0x0000000000000010ULL); }
+  inline void setWhiteKing(u64 value) { setPieces(WHITE_KING, value); }
+
+  inline void setBlackKing() { setBlackKing(0x1000000000000000ULL); }
+  inline void setBlackKing(u64 value) { setPieces(BLACK_KING, value); }
 
   // --- Getters and Setters for aggregate bitboards ---
-  inline u64 getAllWhitePieces() const { return allWhitePieces; }
-  inline u64 getAllBlackPieces() const { return allBlackPieces; }
+  inline u64 getOccupancy(Color color) const { return occupancy[color]; }
+  inline u64 getAllWhitePieces() const { return occupancy[WHITE]; }
+  inline u64 getAllBlackPieces() const { return occupancy[BLACK]; }
 
   inline void setAllWhitePieces() {
-    allWhitePieces = whitePawns | whiteKnights | whiteBishops | whiteRooks |
-                     whiteQueens | whiteKing;
+    const u64 *bb = pieces[WHITE];
+    occupancy[WHITE] = bb[PAWN] | bb[KNIGHT] | bb[BISHOP] | bb[ROOK] |
+                       bb[QUEEN] | bb[KING];
   }
 
   inline void setAllBlackPieces() {
-    allBlackPieces = blackPawns | blackKnights | blackBishops | blackRooks |
-                     blackQueens | blackKing;
+    const u64 *bb = pieces[BLACK];
+    occupancy[BLACK] = bb[PAWN] | bb[KNIGHT] | bb[BISHOP] | bb[ROOK] |
+                       bb[QUEEN] | bb[KING];
   }
 
   inline u64 getAllPieces() const { return allPieces; }
-  inline void setAllPieces() { allPieces = allWhitePieces | allBlackPieces; }
-  // Updates all aggregate bitboards
+  inline void setAllPieces() {
+    allPieces = occupancy[WHITE] | occupancy[BLACK];
+  }
+  // Rebuilds all aggregate bitboards after the piece setters were used.
+  // makeMove/undoMove keep them up to date on their own.
   inline void setALLPiecesAggregate() {
     setAllWhitePieces();
     setAllBlackPieces();
     setAllPieces();
+    updateCheckInfo();
   }
 
-  inline std::vector<Move> getMoveHistory() const { return moveHistory; }
+  // Returns the number of pieces of a type on the board
+  inline int getPieceCount(PieceType piece) const {
+    return __builtin_popcountll(pieces[colorOf(piece)][kindOf(piece)]);
+  }
+
+  // Returns the piece standing on a square, or EMPTY
+  inline PieceType pieceOn(Square sq) const { return board[sq]; }
+
+  // Pieces a move would move and capture, looked up before it is made
+  inline PieceType movedPiece(Move move) const {
+    return board[move.getFromSquare()];
+  }
+  inline PieceType capturedPiece(Move move) const {
+    if (move.getIsEnPassant())
+      return whiteToMove ? BLACK_PAWN : WHITE_PAWN;
+    return board[move.getToSquare()];
+  }
+
+  inline std::vector<Move> getMoveHistory() const {
+    return std::vector<Move>(moveStack, moveStack + historyPly);
+  }
 
   // --- Getters for game state ---
-  inline bool getCanWhiteCastleKS() const { return canWhiteCastleKS; }
-  inline bool getCanWhiteCastleQS() const { return canWhiteCastleQS; }
-  inline bool getCanBlackCastleKS() const { return canBlackCastleKS; }
-  inline bool getCanBlackCastleQS() const { return canBlackCastleQS; }
+  inline int getCastlingRights() const { return st.castlingRights; }
+  inline bool getCanWhiteCastleKS() const {
+    return st.castlingRights & WHITE_KS;
+  }
+  inline bool getCanWhiteCastleQS() const {
+    return st.castlingRights & WHITE_QS;
+  }
+  inline bool getCanBlackCastleKS() const {
+    return st.castlingRights & BLACK_KS;
+  }
+  inline bool getCanBlackCastleQS() const {
+    return st.castlingRights & BLACK_QS;
+  }
   inline bool getWhiteToMove() const { return whiteToMove; }
-  inline Square getEnPassantSquare() const { return enPassantSquare; }
+  inline int getHalfmoveClock() const { return st.halfmoveClock; }
+  using Position::getFullmoveNumber;
+  // Number of moves, including null moves, that can currently be undone
+  inline int getHistoryPly() const { return historyPly; }
+  inline Square getEnPassantSquare() const { return st.enPassantSquare; }
   inline bool getHasWhiteCastled() const { return hasWhiteCastled; }
   inline bool getHasBlackCastled() const { return hasBlackCastled; }
 
+  // --- Cached check information for the current position ---
+  inline u64 getCheckers() const { return st.checkers; }
+  inline bool inCheck() const { return st.checkers != 0; }
+  inline u64 getBlockersForKing(Color color) const {
+    return st.blockersForKing[color];
+  }
+  inline u64 getPinners(Color color) const { return st.pinners[color]; }
+  inline u64 getCheckSquares(PieceKind kind) const {
+    return st.checkSquares[kind];
+  }
+
   // Returns a bitboard of pieces that are pinned to the king
   u64 getPinnedPieces(bool isWhite);
-  inline u64 getZobristHash() const { return zobristHash; }
-  // Initializes the Zobrist hash for the current board state
+  template <Color C> inline u64 pinnedPieces() const {
+    return st.blockersForKing[C] & occupancy[C];
+  }
+  inline u64 getZobristHash() const { return st.zobristHash; }
+  inline u64 getPawnKey() const { return st.pawnKey; }
+  inline u64 getMaterialKey() const { return st.materialKey; }
+  // Initializes the Zobrist hash, pawn key and material key for the current
+  // board state
   void initZobristHash();
 };
 
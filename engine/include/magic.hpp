@@ -8,7 +8,12 @@
 #define MAGIC_HPP
 
 #include "types.hpp"
+#include <array>
+#include <cstddef>
 #include <cstdint>
+#ifdef USE_PEXT
+#include <immintrin.h>
+#endif
 
 using u64 = std::uint64_t;
 
@@ -17,35 +22,77 @@ namespace Magic {
 extern const u64 rookMagics[64];
 extern const u64 bishopMagics[64];
 
-// Masks for relevant occupancy bits for each square
-extern u64 rookMasks[64];
-extern u64 bishopMasks[64];
-
-// Lookup tables for rook and bishop attacks
-extern u64 rookAttacks[64][4096];
-extern u64 bishopAttacks[64][512];
-
 // Number of relevant occupancy bits for each square
 extern const int rookBits[64];
 extern const int bishopBits[64];
 
-// Initializes the magic bitboard tables
-void initMagics();
+// Everything a lookup needs for one square, packed together so a lookup
+// reads one 32-byte entry and then the attack table
+struct alignas(32) SquareMagic {
+  u64 mask;           // Relevant occupancy bits
+  u64 magic;          // Multiplier hashing the masked occupancy
+  const u64 *attacks; // This square's slice of the shared attack table
+  unsigned shift;     // 64 minus the number of relevant bits
+
+  // Index of an occupancy into 'attacks'. Built with USE_PEXT (the
+  // ENGINE_USE_PEXT CMake option), BMI2 PEXT gathers the masked bits
+  // directly; otherwise the magic multiply and shift hash them.
+  inline std::size_t index(u64 occupied) const {
+#ifdef USE_PEXT
+    return _pext_u64(occupied, mask);
+#else
+    return ((occupied & mask) * magic) >> shift;
+#endif
+  }
+};
+
+#ifdef USE_PEXT
+constexpr const char *BACKEND = "pext";
+#else
+constexpr const char *BACKEND = "magic";
+#endif
+
+// Per-square lookup data for rooks and bishops. The attack slices of every
+// square live back to back in one table sized by rookBits and bishopBits.
+// Everything is computed at compile time and lives in read-only memory, so
+// there is nothing to initialize before the first lookup.
+extern const std::array<SquareMagic, 64> rookTable;
+extern const std::array<SquareMagic, 64> bishopTable;
 
 // Generates rook attacks using magic bitboards
 inline u64 getRookAttacks(Square sq, u64 occupied) {
-  occupied &= rookMasks[sq];
-  occupied *= rookMagics[sq];
-  occupied >>= (64 - rookBits[sq]);
-  return rookAttacks[sq][(std::size_t)occupied];
+  const SquareMagic &entry = rookTable[sq];
+  return entry.attacks[entry.index(occupied)];
 }
 
 // Generates bishop attacks using magic bitboards
 inline u64 getBishopAttacks(Square sq, u64 occupied) {
-  occupied &= bishopMasks[sq];
-  occupied *= bishopMagics[sq];
-  occupied >>= (64 - bishopBits[sq]);
-  return bishopAttacks[sq][(std::size_t)occupied];
+  const SquareMagic &entry = bishopTable[sq];
+  return entry.attacks[entry.index(occupied)];
+}
+
+// Returns the squares strictly between two squares sharing a rank, file or
+// diagonal, or an empty bitboard if they are not aligned
+inline u64 betweenSquares(Square a, Square b) {
+  u64 aBB = 1ULL << a;
+  u64 bBB = 1ULL << b;
+  if (getRookAttacks(a, 0ULL) & bBB)
+    return getRookAttacks(a, bBB) & getRookAttacks(b, aBB);
+  if (getBishopAttacks(a, 0ULL) & bBB)
+    return getBishopAttacks(a, bBB) & getBishopAttacks(b, aBB);
+  return 0ULL;
+}
+
+// Returns the whole rank, file or diagonal through two aligned squares, or an
+// empty bitboard if they are not aligned
+inline u64 lineThrough(Square a, Square b) {
+  u64 aBB = 1ULL << a;
+  u64 bBB = 1ULL << b;
+  if (getRookAttacks(a, 0ULL) & bBB)
+    return (getRookAttacks(a, 0ULL) & getRookAttacks(b, 0ULL)) | aBB | bBB;
+  if (getBishopAttacks(a, 0ULL) & bBB)
+    return (getBishopAttacks(a, 0ULL) & getBishopAttacks(b, 0ULL)) | aBB | bBB;
+  return 0ULL;
 }
 } // namespace Magic
 
@@ -1,80 +1,99 @@
 /**
  * @file move.hpp
  * @brief Defines the Move class, which represents a single move in a chess
- * game. This file contains the data structure for a move, including its type,
- * origin, destination, and any special flags.
+ * game. A move is packed into 16 bits: the origin and destination squares and
+ * a 4-bit flag for captures, en passant, castling and promotions. The moving
+ * and captured pieces are not stored; they are looked up on the board.
  */
 #ifndef MOVE_HPP
 #define MOVE_HPP
 #include "types.hpp"
+#include <cstdint>
 #include <iostream>
+#include <type_traits>
+
+// 4-bit move flags. Bit 2 marks captures and bit 3 marks promotions, whose
+// low two bits give the promoted piece (knight, bishop, rook, queen).
+enum MoveFlag : uint16_t {
+  QUIET_MOVE = 0,
+  KING_CASTLE = 2,
+  QUEEN_CASTLE = 3,
+  CAPTURE = 4,
+  EN_PASSANT = 5,
+  KNIGHT_PROMOTION = 8,
+  BISHOP_PROMOTION = 9,
+  ROOK_PROMOTION = 10,
+  QUEEN_PROMOTION = 11,
+  KNIGHT_PROMOTION_CAPTURE = 12,
+  BISHOP_PROMOTION_CAPTURE = 13,
+  ROOK_PROMOTION_CAPTURE = 14,
+  QUEEN_PROMOTION_CAPTURE = 15,
+};
 
 // Represents a single move in a chess game
 class Move {
 private:
-  Square fromSquare;
-  Square toSquare;
-  PieceType pieceType;
-  PieceType capturedPiece;
-  PieceType promotionPiece;
-  bool isCapture;
-  bool isEnPassant;
-  bool isKingSideCastle;
-  bool isQueenSideCastle;
-  bool isPromotion;
+  // Bits 0-5: from square, bits 6-11: to square, bits 12-15: flag
+  uint16_t data;
 
 public:
   // Default constructor for a null move
-  Move()
-      : fromSquare(Square::SQ_NONE), toSquare(Square::SQ_NONE),
-        pieceType(EMPTY), capturedPiece(EMPTY), promotionPiece(EMPTY),
-        isCapture(false), isEnPassant(false), isKingSideCastle(false),
-        isQueenSideCastle(false), isPromotion(false) {}
-  // Constructor for a simple move
-  Move(Square from, Square to, PieceType piece, PieceType captured = EMPTY)
-      : fromSquare(from), toSquare(to), pieceType(piece),
-        capturedPiece(captured), promotionPiece(EMPTY),
-        isCapture(captured != EMPTY), isEnPassant(false),
-        isKingSideCastle(false), isQueenSideCastle(false), isPromotion(false) {}
-
-  // Constructor for special moves (castling, en passant, promotion)
-  Move(Square from, Square to, PieceType piece, PieceType captured,
-       bool enPassant, bool ksCastle, bool qsCastle, bool promotion,
-       PieceType promoPiece = EMPTY)
-      : fromSquare(from), toSquare(to), pieceType(piece),
-        capturedPiece(captured), promotionPiece(promoPiece),
-        isCapture(captured != EMPTY || enPassant), isEnPassant(enPassant),
-        isKingSideCastle(ksCastle), isQueenSideCastle(qsCastle),
-        isPromotion(promotion) {}
+  constexpr Move() : data(0) {}
+  constexpr Move(Square from, Square to, MoveFlag flag = QUIET_MOVE)
+      : data(static_cast<uint16_t>(from | (to << 6) | (flag << 12))) {}
 
-  ~Move() = default;
+  // Builds the flag of a promotion to the given piece kind
+  static constexpr MoveFlag promotionFlag(PieceKind kind, bool capture) {
+    return static_cast<MoveFlag>(KNIGHT_PROMOTION + (capture ? CAPTURE : 0) +
+                                 (kind - KNIGHT));
+  }
 
-  Move &operator=(const Move &other);
-  bool operator==(const Move &other) const;
+  constexpr bool operator==(const Move &other) const {
+    return data == other.data;
+  }
+  constexpr bool operator!=(const Move &other) const {
+    return data != other.data;
+  }
 
   // --- Getters for move details ---
-  inline Square getFromSquare() const { return fromSquare; }
-  inline Square getToSquare() const { return toSquare; }
-  inline PieceType getPieceType() const { return pieceType; }
-  inline PieceType getCapturedPiece() const { return capturedPiece; }
-  inline PieceType getPromotionPiece() const { return promotionPiece; }
+  inline Square getFromSquare() const { return Square(data & 0x3F); }
+  inline Square getToSquare() const { return Square((data >> 6) & 0x3F); }
+  inline MoveFlag getFlag() const { return MoveFlag(data >> 12); }
+  inline uint16_t raw() const { return data; }
+  inline bool isNull() const { return getFromSquare() == getToSquare(); }
+
+  // The promoted piece; its color follows from the destination rank
+  inline PieceType getPromotionPiece() const {
+    if (!getIsPromotion())
+      return EMPTY;
+    Color color = getToSquare() >= A8 ? WHITE : BLACK;
+    return makePiece(color, PieceKind(KNIGHT + (getFlag() & 3)));
+  }
 
   // --- Getters for move flags ---
-  inline bool getIsCapture() const { return isCapture; }
-  inline bool getIsEnPassant() const { return isEnPassant; }
-  inline bool getIsKingSideCastle() const { return isKingSideCastle; }
-  inline bool getIsQueenSideCastle() const { return isQueenSideCastle; }
-  inline bool getIsPromotion() const { return isPromotion; }
+  inline bool getIsCapture() const { return (getFlag() & CAPTURE) != 0; }
+  inline bool getIsEnPassant() const { return getFlag() == EN_PASSANT; }
+  inline bool getIsKingSideCastle() const { return getFlag() == KING_CASTLE; }
+  inline bool getIsQueenSideCastle() const {
+    return getFlag() == QUEEN_CASTLE;
+  }
+  inline bool getIsPromotion() const {
+    return (getFlag() & KNIGHT_PROMOTION) != 0;
+  }
 
   // --- Convenience checkers ---
   // Checks if the move is a castling move
   inline bool isCastling() const {
-    return isKingSideCastle || isQueenSideCastle;
+    return getFlag() == KING_CASTLE || getFlag() == QUEEN_CASTLE;
   }
   // Checks if the move is a special move (en passant, castling, or promotion)
   inline bool isSpecialMove() const {
-    return isEnPassant || isCastling() || isPromotion;
+    return getIsEnPassant() || isCastling() || getIsPromotion();
   }
   friend std::ostream &operator<<(std::ostream &os, const Move &move);
 };
+
+static_assert(sizeof(Move) == 2, "Move must stay 16 bits");
+static_assert(std::is_trivially_copyable<Move>::value,
+              "Move must stay trivially copyable");
 #endif
@@ -8,6 +8,7 @@
 #define MOVEGEN_HPP
 
 #include "board.hpp"
+#include "movelist.hpp"
 #include "tables.hpp"
 #include <vector>
 
@@ -27,45 +28,107 @@ u64 blackPawnAttacks(u64 pawnLoc);
 u64 allEnemyAttacks(Board &board, bool isWhite);
 
 u64 kingLegalMoves(Board &board, bool isWhite);
+
+// --- Color-templated variants ---
+// The color is a template parameter, so shift directions and piece selection
+// are fixed at compile time. The bool functions above dispatch to these.
+
+// Squares attacked by pawns of color C
+template <Color C> inline u64 pawnAttacks(u64 pawnLoc) {
+  if constexpr (C == WHITE)
+    return ((pawnLoc & Tables::clearFile[0]) << 7) |
+           ((pawnLoc & Tables::clearFile[7]) << 9);
+  else
+    return ((pawnLoc & Tables::clearFile[0]) >> 9) |
+           ((pawnLoc & Tables::clearFile[7]) >> 7);
+}
+
+// Shifts a bitboard one rank forward from the point of view of color C
+template <Color C> inline u64 pawnPush(u64 bb) {
+  return C == WHITE ? bb << 8 : bb >> 8;
+}
+
+// Pseudo-legal pushes and captures of pawns of color C
+template <Color C>
+inline u64 pawnMoves(u64 pawnLoc, u64 allPieces, u64 enemyPieces) {
+  constexpr int thirdRank = C == WHITE ? 2 : 5;
+  u64 singlePush = pawnPush<C>(pawnLoc) & ~allPieces;
+  u64 doublePush =
+      pawnPush<C>(singlePush & Tables::maskRank[thirdRank]) & ~allPieces;
+  return singlePush | doublePush | (pawnAttacks<C>(pawnLoc) & enemyPieces);
+}
+
+// Every square attacked by color C under the given occupancy
+template <Color C> u64 attacksBy(const Board &board, u64 occupied);
+
+// Every square attacked by a set of diagonal and a set of straight sliders.
+// Uses an AVX2 Kogge-Stone fill when the CPU supports it, chosen at startup,
+// and per-piece magic lookups otherwise.
+u64 sliderAttacks(u64 diagonal, u64 straight, u64 occupied);
+
+// The two implementations behind sliderAttacks. The scalar one goes through
+// the configured Magic:: backend. The AVX2 fill may only be called when
+// hasAvx2SliderAttacks() is true; without x86 support it forwards to the
+// scalar code.
+u64 sliderAttacksScalar(u64 diagonal, u64 straight, u64 occupied);
+u64 sliderAttacksAvx2(u64 diagonal, u64 straight, u64 occupied);
+bool hasAvx2SliderAttacks();
 }; // namespace validMoveBB
 
-// Contains functions for generating lists of legal and pseudo-legal moves
+// Contains functions for generating lists of legal and pseudo-legal moves.
+// Each generator appends to a caller-supplied MoveList; the std::vector
+// overloads wrap them for callers outside the search.
 class MoveGeneration {
 public:
   // --- Pseudo-legal move generation ---
+  static void generateKingMoves(Board &board, bool isWhite, MoveList &moves);
+  static void generateKnightMoves(Board &board, bool isWhite, MoveList &moves);
+  static void generatePawnMoves(Board &board, bool isWhite, MoveList &moves);
+  static void generateRookMoves(Board &board, bool isWhite, MoveList &moves);
+  static void generateBishopMoves(Board &board, bool isWhite, MoveList &moves);
+  static void generateQueenMoves(Board &board, bool isWhite, MoveList &moves);
+
+  // --- Legal move generation ---
+  // Generates all legal moves for the given side. Legality comes from the
+  // pin, check and king danger masks of the position, without making moves.
+  // In check, the evasion generator below is used automatically.
+  static void generateAllMoves(Board &board, bool isWhite, MoveList &moves);
+  // Generates only the replies to a check: king moves, captures of a lone
+  // checker and interpositions. The side to move must be in check.
+  static void generateEvasions(Board &board, MoveList &moves);
+  // Generate the legal moves of the side to move in two disjoint stages:
+  // captures and promotions, then everything else
+  static void generateLegalCaptures(Board &board, MoveList &moves);
+  static void generateLegalQuiets(Board &board, MoveList &moves);
+  // Generates the legal quiet moves that give direct or discovered check.
+  // The side to move must not be in check.
+  static void generateQuietChecks(Board &board, MoveList &moves);
+  // Checks a single move for legality without generating the full list
+  static bool isLegal(Board &board, Move move);
+
+  // --- Special move generation ---
+  static void generatePawnPromotionMoves(Board &board, u64 pawnLoc,
+                                         bool isWhite, MoveList &moves);
+  static void generateCastlingMoves(Board &board, bool isWhite,
+                                    MoveList &moves);
+  static void generateEnPassantMoves(Board &board, bool isWhite,
+                                     MoveList &moves);
+  static void generateCaptures(Board &board, bool isWhite, MoveList &moves);
+
+  // --- std::vector overloads ---
   static std::vector<Move> generateKingMoves(Board &board, bool isWhite);
   static std::vector<Move> generateKnightMoves(Board &board, bool isWhite);
   static std::vector<Move> generatePawnMoves(Board &board, bool isWhite);
   static std::vector<Move> generateRookMoves(Board &board, bool isWhite);
   static std::vector<Move> generateBishopMoves(Board &board, bool isWhite);
   static std::vector<Move> generateQueenMoves(Board &board, bool isWhite);
-
-  // --- Legal move generation ---
-  // Generates all legal moves for the current player
   static std::vector<Move> generateAllMoves(Board &board, bool isWhite);
-  // Filters a list of moves to only include legal moves while in check
-  static std::vector<Move>
-  generateLegalMovesWhileInCheck(Board &board, bool isWhite,
-                                 std::vector<Move> allMoves);
-
   static std::vector<Move> generateKingLegalMoves(Board &board, bool isWhite);
-  static std::vector<Move> generateKnightLegalMoves(Board &board, bool isWhite,
-                                                    bool inCheck,
-                                                    u64 pinnedPieces);
-  static std::vector<Move> generatePawnLegalMoves(Board &board, bool isWhite,
-                                                  bool inCheck,
-                                                  u64 pinnedPieces);
-  static std::vector<Move> generateRookLegalMoves(Board &board, bool isWhite,
-                                                  bool inCheck,
-                                                  u64 pinnedPieces);
-  static std::vector<Move> generateBishopLegalMoves(Board &board, bool isWhite,
-                                                    bool inCheck,
-                                                    u64 pinnedPieces);
-  static std::vector<Move> generateQueenLegalMoves(Board &board, bool isWhite,
-                                                   bool inCheck,
-                                                   u64 pinnedPieces);
-
-  // --- Special move generation ---
+  static std::vector<Move> generatePawnLegalMoves(Board &board, bool isWhite);
+  static std::vector<Move> generateKnightLegalMoves(Board &board, bool isWhite);
+  static std::vector<Move> generateBishopLegalMoves(Board &board, bool isWhite);
+  static std::vector<Move> generateRookLegalMoves(Board &board, bool isWhite);
+  static std::vector<Move> generateQueenLegalMoves(Board &board, bool isWhite);
   static std::vector<Move> generatePawnPromotionMoves(Board &board, u64 pawnLoc,
                                                       bool isWhite);
   static std::vector<Move> generateCastlingMoves(Board &board, bool isWhite);
@@ -0,0 +1,61 @@
+/**
+ * @file movelist.hpp
+ * @brief Defines MoveList, a fixed-capacity list of moves that lives on the
+ * stack. Move generators append into a list owned by the caller, so search,
+ * quiescence and perft can generate moves without touching the heap.
+ */
+#ifndef MOVELIST_HPP
+#define MOVELIST_HPP
+#include "move.hpp"
+
+// No reachable chess position has more than 218 legal moves
+constexpr int MAX_MOVES = 256;
+
+class MoveList {
+private:
+  Move moves[MAX_MOVES];
+  int count = 0;
+
+public:
+  MoveList() = default;
+
+  inline void push_back(Move move) { moves[count++] = move; }
+  inline void emplace_back(Square from, Square to, MoveFlag flag = QUIET_MOVE) {
+    moves[count++] = Move(from, to, flag);
+  }
+  inline void clear() { count = 0; }
+
+  inline int size() const { return count; }
+  inline bool empty() const { return count == 0; }
+
+  inline Move &operator[](int i) { return moves[i]; }
+  inline const Move &operator[](int i) const { return moves[i]; }
+
+  inline Move *begin() { return moves; }
+  inline Move *end() { return moves + count; }
+  inline const Move *begin() const { return moves; }
+  inline const Move *end() const { return moves + count; }
+
+  inline bool contains(Move move) const {
+    for (int i = 0; i < count; i++)
+      if (moves[i] == move)
+        return true;
+    return false;
+  }
+
+  // Moves 'move' to the front, keeping the order of the others. Returns false
+  // if the move is not in the list.
+  inline bool moveToFront(Move move) {
+    for (int i = 0; i < count; i++) {
+      if (moves[i] == move) {
+        for (; i > 0; i--)
+          moves[i] = moves[i - 1];
+        moves[0] = move;
+        return true;
+      }
+    }
+    return false;
+  }
+};
+
+#endif
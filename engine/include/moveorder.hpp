@@ -6,12 +6,55 @@
 class MoveOrder {
 public:
   MoveOrder() {}
-  static std::vector<Move> getOrderedMoves(Board &board);
-  static std::vector<Move> getOrderedMoves(Board &board,
-                                           std::vector<Move> &moves);
+  // Fills 'moves' with all legal moves, best first
+  static void getOrderedMoves(Board &board, MoveList &moves);
+  // Sorts an already generated list, best first
+  static void orderMoves(Board &board, MoveList &moves);
   static int getMoveScore(Board &board, Move move);
-  static int getCaptureScore(const Move &move);
-  static void orderCaptures(std::vector<Move> &captures);
+  static int getCaptureScore(const Board &board, Move move);
+  static void orderCaptures(const Board &board, MoveList &captures);
+};
+
+// Hands out the legal moves of a position one at a time, in stages: the TT
+// move, good captures, killers, quiet moves and finally losing captures. A
+// stage is generated only when the earlier ones are exhausted, and each stage
+// is selected incrementally rather than sorted up front, so a node that cuts
+// off on its first moves does little ordering work.
+class MovePicker {
+public:
+  // 'killers' points at the two killer moves of the node, or is null
+  MovePicker(Board &board, Move ttMove, const Move *killers);
+
+  // Returns the next move, or a null move once every move has been returned
+  Move next();
+
+private:
+  enum Stage {
+    TT_STAGE,
+    GEN_CAPTURES,
+    GOOD_CAPTURES,
+    KILLERS,
+    GEN_QUIETS,
+    QUIETS,
+    BAD_CAPTURES,
+    DONE
+  };
+
+  Board &board;
+  Move ttMove;
+  Move killers[2];
+  int stage;
+
+  MoveList moves;
+  int scores[MAX_MOVES];
+  int current = 0;
+  MoveList badCaptures;
+  int badCurrent = 0;
+  int killerIndex = 0;
+
+  // Swaps the best remaining move of 'moves' to 'current' and returns it
+  Move selectBest();
+  bool isKiller(Move move) const;
 };
 
 #endif
@@ -1,6 +1,7 @@
 #ifndef TABLES_HPP
 #define TABLES_HPP
 
+#include <array>
 #include <cstdint>
 
 using u64 = uint64_t;
@@ -12,5 +13,46 @@ extern const u64 maskFile[8];
 extern const u64 clearRank[8];
 extern const u64 clearFile[8];
 extern const u64 Piece[64];
+
+namespace detail {
+// Squares reached from 'sq' by each (file, rank) step that stays on the board
+template <int N>
+constexpr u64 leaperAttacks(int sq, const int (&steps)[N][2]) {
+  u64 attacks = 0;
+  for (int i = 0; i < N; i++) {
+    int file = sq % 8 + steps[i][0];
+    int rank = sq / 8 + steps[i][1];
+    if (file >= 0 && file < 8 && rank >= 0 && rank < 8)
+      attacks |= 1ULL << (rank * 8 + file);
+  }
+  return attacks;
+}
+
+template <int N>
+constexpr std::array<u64, 64> leaperTable(const int (&steps)[N][2]) {
+  std::array<u64, 64> table{};
+  for (int sq = 0; sq < 64; sq++)
+    table[sq] = leaperAttacks(sq, steps);
+  return table;
+}
+
+constexpr int knightSteps[8][2] = {{1, 2},   {2, 1},   {2, -1}, {1, -2},
+                                   {-1, -2}, {-2, -1}, {-2, 1}, {-1, 2}};
+constexpr int kingSteps[8][2] = {{0, 1},  {1, 1},   {1, 0},  {1, -1},
+                                 {0, -1}, {-1, -1}, {-1, 0}, {-1, 1}};
+constexpr int whitePawnSteps[2][2] = {{-1, 1}, {1, 1}};
+constexpr int blackPawnSteps[2][2] = {{-1, -1}, {1, -1}};
+} // namespace detail
+
+// Attacks of a single knight, king or pawn, indexed by square (and by Color
+// for pawns). Setwise shifts remain the better choice when many pieces are
+// attacked from at once.
+inline constexpr std::array<u64, 64> KnightAttacks =
+    detail::leaperTable(detail::knightSteps);
+inline constexpr std::array<u64, 64> KingAttacks =
+    detail::leaperTable(detail::kingSteps);
+inline constexpr std::array<u64, 64> PawnAttacks[2] = {
+    detail::leaperTable(detail::whitePawnSteps),
+    detail::leaperTable(detail::blackPawnSteps)};
 } // namespace Tables
 #endif
@@ -17,6 +17,24 @@ enum PieceType {
   BLACK_KING,
 };
 
+enum Color { WHITE, BLACK };
+
+// The opposing color
+constexpr Color operator~(Color color) { return static_cast<Color>(color ^ 1); }
+
+enum PieceKind { PAWN, KNIGHT, BISHOP, ROOK, QUEEN, KING };
+
+// Splits a colored piece into its color and kind. Not valid for EMPTY.
+constexpr Color colorOf(PieceType piece) {
+  return piece >= BLACK_PAWN ? BLACK : WHITE;
+}
+constexpr PieceKind kindOf(PieceType piece) {
+  return static_cast<PieceKind>((piece - 1) % 6);
+}
+constexpr PieceType makePiece(Color color, PieceKind kind) {
+  return static_cast<PieceType>(1 + color * 6 + kind);
+}
+
 enum Square {
   A1,
   B1,
@@ -66,7 +66,7 @@ PieceType getPieceTypeAt(Board &board, Square square);
 int getCaptureCount(Board &board, PieceType pieceType, bool isWhite);
 
 // Converts a string in algebraic notation to a square index
-Square stringToSquare(const std::string &square);
+Square stringToSquare(std::string_view square);
 // Converts a character to a piece type
 PieceType charToPiece(char c);
 
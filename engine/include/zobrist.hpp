@@ -19,6 +19,8 @@ private:
   u64 castleKeys[16];    // Keys for each possible castling rights state
   u64 enPassantKeys[64]; // Keys for each possible en passant square
   u64 blackToMoveKey;    // Key to indicate if it is black's turn to move
+  // Keys for the n-th piece of each type, used by the material key
+  u64 materialKeys[12][64];
 
 public:
   Zobrist();
@@ -33,6 +35,10 @@ public:
     return enPassantKeys[square];
   };
   inline u64 getBlackToMoveKey() const { return blackToMoveKey; };
+  // Key toggled when a piece's count goes from 'count' to 'count + 1'
+  inline u64 getMaterialKey(PieceType piece, int count) const {
+    return materialKeys[piece - 1][count];
+  };
 };
 
 #endif
@@ -9,7 +9,8 @@ u64 Perft::perftRecursive(Board &board, int depth, bool isWhite) {
     return 1;
   }
 
-  std::vector<Move> moves = MoveGeneration::generateAllMoves(board, isWhite);
+  MoveList moves;
+  MoveGeneration::generateAllMoves(board, isWhite, moves);
 
   if (depth == 1) {
     return moves.size();
@@ -30,7 +31,8 @@ u64 Perft::perftDivide(Board &board, int depth) {
     return 0;
 
   bool isWhite = board.getWhiteToMove();
-  std::vector<Move> moves = MoveGeneration::generateAllMoves(board, isWhite);
+  MoveList moves;
+  MoveGeneration::generateAllMoves(board, isWhite, moves);
 
   u64 totalNodes = 0;
 
@@ -1,4 +1,3 @@
-#include "../include/magic.hpp"
 #include "../include/perft.hpp"
 #include <cassert>
 #include <fstream>
@@ -130,7 +129,6 @@ void runBasicPerftTests() {
 // }
 
 int main() {
-  Magic::initMagics();
   std::cout << "Starting Perft Tests..." << std::endl;
 
   // Run basic tests
@@ -20,6 +20,13 @@ int ChessAI::minimax(Board &board, int depth, long long int alpha,
                      long long int beta, bool maximizingPlayer) {
 
   nodesSearched++;
+
+  // Repetitions and the fifty-move rule end the line before the TT is probed,
+  // so cycle positions are never stored
+  int ply = board.getHistoryPly() - rootPly;
+  if (ply > 0 && board.isDraw(ply))
+    return 0;
+
   u64 hash = board.getZobristHash();
   int originalAlpha = alpha;
 
@@ -36,22 +43,13 @@ int ChessAI::minimax(Board &board, int depth, long long int alpha,
     return quiescence(board, alpha, beta, maximizingPlayer, 0);
   }
 
-  // Get moves, ordered to improve alpha-beta pruning
-  std::vector<Move> moves = MoveOrder::getOrderedMoves(board);
-
-  // If a move was found in the TT, try it first
-  if (ttMove.getFromSquare() != ttMove.getToSquare()) {
-    auto it = std::find(moves.begin(), moves.end(), ttMove);
-    if (it != moves.end()) {
-      moves.erase(it);
-      moves.insert(moves.begin(), ttMove);
-    }
-  }
+  // Moves are handed out lazily, best first, starting with the TT move
+  MovePicker picker(board, ttMove, killersAt(ply));
+  Move move = picker.next();
 
   // Handle checkmate and stalemate
-  if (moves.empty()) {
-    bool currentPlayerTurn = board.getWhiteToMove();
-    bool currentPlayerInCheck = board.isKingChecked(currentPlayerTurn);
+  if (move.isNull()) {
+    bool currentPlayerInCheck = board.inCheck();
     if (currentPlayerInCheck && maximizingPlayer)
       return INT_MIN + depth; // Checkmated
     else if (currentPlayerInCheck && !maximizingPlayer)
@@ -60,11 +58,11 @@ int ChessAI::minimax(Board &board, int depth, long long int alpha,
       return 0; // Stalemate
   }
 
-  Move bestMove = moves[0];
+  Move bestMove = move;
 
   if (maximizingPlayer) {
     int maxEval = INT_MIN;
-    for (Move &move : moves) {
+    for (; !move.isNull(); move = picker.next()) {
       board.makeMove(move);
       int eval = minimax(board, depth - 1, alpha, beta, false);
       board.undoMove();
@@ -76,6 +74,7 @@ int ChessAI::minimax(Board &board, int depth, long long int alpha,
 
       alpha = std::max((long long int)alpha, (long long int)eval);
       if (beta <= alpha) {
+        storeKiller(ply, move);
         break; // Beta cutoff
       }
     }
@@ -94,7 +93,7 @@ int ChessAI::minimax(Board &board, int depth, long long int alpha,
 
   } else { // Minimizing player
     int minEval = INT_MAX;
-    for (Move &move : moves) {
+    for (; !move.isNull(); move = picker.next()) {
       board.makeMove(move);
       int eval = minimax(board, depth - 1, alpha, beta, true);
       board.undoMove();
@@ -106,6 +105,7 @@ int ChessAI::minimax(Board &board, int depth, long long int alpha,
 
       beta = std::min((long long int)beta, (long long int)eval);
       if (beta <= alpha) {
+        storeKiller(ply, move);
         break; // Alpha cutoff
       }
     }
@@ -124,27 +124,38 @@ int ChessAI::minimax(Board &board, int depth, long long int alpha,
   }
 }
 
+// Remembers a quiet move that caused a cutoff, keeping the two most recent
+void ChessAI::storeKiller(int ply, Move move) {
+  Move *slots = killersAt(ply);
+  if (!slots || move.getIsCapture() || move.getIsPromotion() ||
+      move == slots[0])
+    return;
+  slots[1] = slots[0];
+  slots[0] = move;
+}
+
 // Iterative deepening search for the best move
 Move ChessAI::getBestMove(Board &board, int maxDepth) {
   nodesSearched = 0;
   ttHits = 0;
   qNodes = 0;
+  // Make room for the search before the root ply is taken
+  board.trimHistory();
+  rootPly = board.getHistoryPly();
+  for (auto &slots : killers)
+    slots[0] = slots[1] = Move();
   auto start = std::chrono::high_resolution_clock::now();
 
-  std::vector<Move> moves = MoveOrder::getOrderedMoves(board);
+  MoveList moves;
+  MoveOrder::getOrderedMoves(board, moves);
   if (moves.empty())
     return Move();
 
   // Check transposition table for a pre-existing best move
   u64 hash = board.getZobristHash();
   Move ttMove = tt.getBestMove(hash);
-  if (ttMove.getFromSquare() != ttMove.getToSquare()) {
-    auto it = std::find(moves.begin(), moves.end(), ttMove);
-    if (it != moves.end()) {
-      moves.erase(it);
-      moves.insert(moves.begin(), ttMove);
-    }
-  }
+  if (!ttMove.isNull())
+    moves.moveToFront(ttMove);
 
   Move bestMove = moves[0];
 
@@ -167,11 +178,7 @@ Move ChessAI::getBestMove(Board &board, int maxDepth) {
     bestMove = currentBestMove;
 
     // Move the best move to the front of the list for the next iteration
-    auto it = std::find(moves.begin(), moves.end(), bestMove);
-    if (it != moves.end()) {
-      moves.erase(it);
-      moves.insert(moves.begin(), bestMove);
-    }
+    moves.moveToFront(bestMove);
   }
 
   auto end = std::chrono::high_resolution_clock::now();
@@ -206,41 +213,55 @@ int ChessAI::quiescence(Board &board, int alpha, int beta,
     return standPat;
   }
 
-  if (maximizingPlayer) {
-    if (standPat >= beta) {
-      return beta;
-    }
-    if (standPat > alpha) {
-      alpha = standPat;
-    }
+  // In check there is no standing pat: every evasion is searched, and having
+  // none is mate
+  bool inCheck = board.inCheck();
+  MoveList tacticalMoves;
+  if (inCheck) {
+    MoveGeneration::generateEvasions(board, tacticalMoves);
+    if (tacticalMoves.empty())
+      return maximizingPlayer ? INT_MIN : INT_MAX;
+    MoveOrder::orderMoves(board, tacticalMoves);
   } else {
-    if (standPat <= alpha) {
-      return alpha;
-    }
-    if (standPat < beta) {
-      beta = standPat;
+    if (maximizingPlayer) {
+      if (standPat >= beta) {
+        return beta;
+      }
+      if (standPat > alpha) {
+        alpha = standPat;
+      }
+    } else {
+      if (standPat <= alpha) {
+        return alpha;
+      }
+      if (standPat < beta) {
+        beta = standPat;
+      }
     }
-  }
 
-  // Generate only tactical moves (captures and promotions)
-  std::vector<Move> tacticalMoves = generateTacticalMoves(board);
+    // Delta pruning: if no capture can raise the score enough, skip them.
+    // Quiet checks are not bounded by material and are still searched.
+    const int DELTA = 900;
+    bool capturesHopeless = maximizingPlayer ? standPat + DELTA < alpha
+                                             : standPat - DELTA > beta;
 
-  if (tacticalMoves.empty()) {
-    return standPat;
-  }
-  MoveOrder::orderCaptures(tacticalMoves);
+    // Generate only tactical moves (captures and promotions)
+    if (!capturesHopeless) {
+      generateTacticalMoves(board, tacticalMoves);
+      MoveOrder::orderCaptures(board, tacticalMoves);
+    }
 
-  // Delta pruning: if a capture can't raise the score enough, prune it
-  const int DELTA = 900;
-  if (maximizingPlayer && standPat + DELTA < alpha) {
-    return standPat;
-  }
-  if (!maximizingPlayer && standPat - DELTA > beta) {
-    return standPat;
+    // On the first ply, quiet checks follow the captures
+    if (qDepth == 0 && quiescenceChecks)
+      MoveGeneration::generateQuietChecks(board, tacticalMoves);
+
+    if (tacticalMoves.empty()) {
+      return standPat;
+    }
   }
 
   if (maximizingPlayer) {
-    int maxEval = standPat;
+    int maxEval = inCheck ? INT_MIN : standPat;
     for (Move &move : tacticalMoves) {
       board.makeMove(move);
       int eval = quiescence(board, alpha, beta, false, qDepth + 1);
@@ -255,7 +276,7 @@ int ChessAI::quiescence(Board &board, int alpha, int beta,
     }
     return maxEval;
   } else {
-    int minEval = standPat;
+    int minEval = inCheck ? INT_MAX : standPat;
     for (Move &move : tacticalMoves) {
       board.makeMove(move);
       int eval = quiescence(board, alpha, beta, true, qDepth + 1);
@@ -272,32 +293,9 @@ int ChessAI::quiescence(Board &board, int alpha, int beta,
   }
 }
 
-// Generates tactical moves (captures and promotions) for the quiescence search
-std::vector<Move> ChessAI::generateTacticalMoves(Board &board) {
-  bool isWhite = board.getWhiteToMove();
-
-  std::vector<Move> tactical = MoveGeneration::generateCaptures(board, isWhite);
-
-  // Add pawn promotions to the list of tactical moves
-  u64 pawns = isWhite ? board.getWhitePawns() : board.getBlackPawns();
-  u64 promoPawns =
-      isWhite ? pawns & Tables::maskRank[6] : pawns & Tables::maskRank[1];
-
-  if (promoPawns != 0) {
-    std::vector<Move> promos =
-        MoveGeneration::generatePawnPromotionMoves(board, promoPawns, isWhite);
-    tactical.insert(tactical.end(), promos.begin(), promos.end());
-  }
-
-  // Filter out illegal tactical moves
-  std::vector<Move> legalTacticalMoves;
-  for (Move &move : tactical) {
-    board.makeMove(move);
-    if (!board.isKingChecked(isWhite)) {
-      legalTacticalMoves.push_back(move);
-    }
-    board.undoMove();
-  }
-
-  return tactical;
+// Generates tactical moves (captures and promotions) for the quiescence search.
+// The pin and check masks make every generated move legal, so nothing has to
+// be made and undone here.
+void ChessAI::generateTacticalMoves(Board &board, MoveList &moves) {
+  MoveGeneration::generateLegalCaptures(board, moves);
 }
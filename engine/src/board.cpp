@@ -6,14 +6,51 @@
  * positions from FEN.
  */
 #include "../include/board.hpp"
+#include "../include/magic.hpp"
 #include "../include/movegen.hpp"
 #include "../include/utils.hpp"
-#include <cctype>
-#include <sstream>
+#include <algorithm>
+#include <charconv>
 #include <string>
 
 Zobrist Board::zobrist;
 
+// Castling rights that survive a move touching each square: moving the king or
+// a rook, or capturing a rook on its home square, clears the matching rights
+static const int castlingRightsMask[64] = {
+    ALL_CASTLING & ~WHITE_QS, ALL_CASTLING, ALL_CASTLING, ALL_CASTLING,
+    ALL_CASTLING & ~(WHITE_KS | WHITE_QS), ALL_CASTLING, ALL_CASTLING,
+    ALL_CASTLING & ~WHITE_KS,
+    ALL_CASTLING, ALL_CASTLING, ALL_CASTLING, ALL_CASTLING, ALL_CASTLING,
+    ALL_CASTLING, ALL_CASTLING, ALL_CASTLING,
+    ALL_CASTLING, ALL_CASTLING, ALL_CASTLING, ALL_CASTLING, ALL_CASTLING,
+    ALL_CASTLING, ALL_CASTLING, ALL_CASTLING,
+    ALL_CASTLING, ALL_CASTLING, ALL_CASTLING, ALL_CASTLING, ALL_CASTLING,
+    ALL_CASTLING, ALL_CASTLING, ALL_CASTLING,
+    ALL_CASTLING, ALL_CASTLING, ALL_CASTLING, ALL_CASTLING, ALL_CASTLING,
+    ALL_CASTLING, ALL_CASTLING, ALL_CASTLING,
+    ALL_CASTLING, ALL_CASTLING, ALL_CASTLING, ALL_CASTLING, ALL_CASTLING,
+    ALL_CASTLING, ALL_CASTLING, ALL_CASTLING,
+    ALL_CASTLING, ALL_CASTLING, ALL_CASTLING, ALL_CASTLING, ALL_CASTLING,
+    ALL_CASTLING, ALL_CASTLING, ALL_CASTLING,
+    ALL_CASTLING & ~BLACK_QS, ALL_CASTLING, ALL_CASTLING, ALL_CASTLING,
+    ALL_CASTLING & ~(BLACK_KS | BLACK_QS), ALL_CASTLING, ALL_CASTLING,
+    ALL_CASTLING & ~BLACK_KS};
+
+// FEN character for each piece type, indexed by PieceType
+static const char pieceChars[] = " PNBRQKpnbrqk";
+
+// Returns the next space-separated field of a FEN string and advances 'pos'
+// past it. Returns an empty view once the string is exhausted.
+static std::string_view nextFenField(std::string_view fen, size_t &pos) {
+  while (pos < fen.size() && fen[pos] == ' ')
+    pos++;
+  size_t start = pos;
+  while (pos < fen.size() && fen[pos] != ' ')
+    pos++;
+  return fen.substr(start, pos - start);
+}
+
 // Initializes the board to the standard starting position
 Board::Board() {
   setWhitePawns();
@@ -29,8 +66,6 @@ Board::Board() {
   setWhiteKing();
   setBlackKing();
   setALLPiecesAggregate();
-  stateHistory = {};
-  moveHistory = {};
   initZobristHash();
 }
 
@@ -51,746 +86,304 @@ Board::Board(u64 wPawns, u64 bPawns, u64 wKnights, u64 bKnights, u64 wBishops,
   setWhiteKing(wKing);
   setBlackKing(bKing);
   setALLPiecesAggregate();
-  stateHistory = {};
-  moveHistory = {};
   initZobristHash();
 }
 
 // Initializes the board from a FEN string
-Board::Board(const std::string &fen) {
-  loadFromFen(fen);
-  stateHistory = {};
-  moveHistory = {};
-  initZobristHash();
+Board::Board(std::string_view fen) { loadFromFen(fen); }
+
+Board::Board(const Position &position) : Position(position) {}
+
+Board::Board(const Board &other) : Position(other) {
+  historyPly = other.historyPly;
+  std::copy(other.stateStack, other.stateStack + historyPly, stateStack);
+  std::copy(other.moveStack, other.moveStack + historyPly, moveStack);
 }
 
 Board &Board::operator=(const Board &other) {
   if (this == &other)
     return *this;
-  whitePawns = other.whitePawns;
-  whiteKnights = other.whiteKnights;
-  whiteBishops = other.whiteBishops;
-  whiteRooks = other.whiteRooks;
-  whiteQueens = other.whiteQueens;
-  whiteKing = other.whiteKing;
-  blackPawns = other.blackPawns;
-  blackKnights = other.blackKnights;
-  blackBishops = other.blackBishops;
-  blackRooks = other.blackRooks;
-  blackQueens = other.blackQueens;
-  blackKing = other.blackKing;
-  allWhitePieces = other.allWhitePieces;
-  allBlackPieces = other.allBlackPieces;
-  allPieces = other.allPieces;
-  canWhiteCastleKS = other.canWhiteCastleKS;
-  canWhiteCastleQS = other.canWhiteCastleQS;
-  canBlackCastleKS = other.canBlackCastleKS;
-  canBlackCastleQS = other.canBlackCastleQS;
-  enPassantSquare = other.enPassantSquare;
-  whiteToMove = other.whiteToMove;
+  Position::operator=(other);
+  historyPly = other.historyPly;
+  std::copy(other.stateStack, other.stateStack + historyPly, stateStack);
+  std::copy(other.moveStack, other.moveStack + historyPly, moveStack);
   return *this;
 }
 
 // Checks if the king of the specified color is under attack
 bool Board::isKingChecked(bool isWhite) {
-  u64 enemyAttacks = validMoveBB::allEnemyAttacks(*this, !isWhite);
-  u64 king = isWhite ? getWhiteKing() : getBlackKing();
-  return (enemyAttacks & king) != 0;
+  if (isWhite == whiteToMove)
+    return st.checkers != 0;
+
+  Color us = isWhite ? WHITE : BLACK;
+  u64 king = pieces[us][KING];
+  return king && (attackersTo(Utils::bitboardToSquare(king), allPieces) &
+                  occupancy[~us]) != 0;
+}
+
+// Returns the pieces of both colors attacking a square under the given
+// occupancy, found by looking outward from the square itself
+u64 Board::attackersTo(Square sq, u64 occupied) const {
+  return (Tables::PawnAttacks[BLACK][sq] & pieces[WHITE][PAWN]) |
+         (Tables::PawnAttacks[WHITE][sq] & pieces[BLACK][PAWN]) |
+         (Tables::KnightAttacks[sq] &
+          (pieces[WHITE][KNIGHT] | pieces[BLACK][KNIGHT])) |
+         (Tables::KingAttacks[sq] &
+          (pieces[WHITE][KING] | pieces[BLACK][KING])) |
+         (Magic::getBishopAttacks(sq, occupied) &
+          (pieces[WHITE][BISHOP] | pieces[BLACK][BISHOP] |
+           pieces[WHITE][QUEEN] | pieces[BLACK][QUEEN])) |
+         (Magic::getRookAttacks(sq, occupied) &
+          (pieces[WHITE][ROOK] | pieces[BLACK][ROOK] | pieces[WHITE][QUEEN] |
+           pieces[BLACK][QUEEN]));
 }
 
 // Applies a move to the board, updating the board state and Zobrist hash
 void Board::makeMove(const Move &move) {
 
-  // Store current state for undoing the move
-  undoInfo undo;
-  undo.move = move;
-  undo.capturedPiece = move.getCapturedPiece();
-  undo.enPassantSquare = enPassantSquare;
-  undo.canWhiteCastleKS = canWhiteCastleKS;
-  undo.canWhiteCastleQS = canWhiteCastleQS;
-  undo.canBlackCastleKS = canBlackCastleKS;
-  undo.canBlackCastleQS = canBlackCastleQS;
-  undo.whiteToMove = whiteToMove;
-  undo.hasWhiteCastled = hasWhiteCastled;
-  undo.hasBlackCastled = hasBlackCastled;
-  undo.zobristHash = zobristHash;
-  stateHistory.push_back(undo);
+  // Push the current state so undoMove can restore it. A full stack gives up
+  // its older half rather than overflow.
+  if (historyPly == STATE_STACK_SIZE)
+    dropOldHistory(STATE_STACK_SIZE / 2);
+  stateStack[historyPly] = st;
+  moveStack[historyPly] = move;
+  historyPly++;
 
   Square fromSquare = move.getFromSquare();
   Square toSquare = move.getToSquare();
-  PieceType piece = move.getPieceType();
-  PieceType capturedPiece = move.getCapturedPiece();
-  bool isCapture = move.getIsCapture();
-  bool isPromotion = move.getIsPromotion();
-  bool isEnPassant = move.getIsEnPassant();
-  bool isKingSideCastling = move.getIsKingSideCastle();
-  bool isQueenSideCastling = move.getIsQueenSideCastle();
-
-  int oldCastlingRights =
-      (canWhiteCastleKS ? 1 : 0) | (canWhiteCastleQS ? 2 : 0) |
-      (canBlackCastleKS ? 4 : 0) | (canBlackCastleQS ? 8 : 0);
+  PieceType piece = board[fromSquare];
+  u64 &zobristHash = st.zobristHash;
 
-  // Update Zobrist hash for en passant square
-  if (enPassantSquare != SQ_NONE) {
-    zobristHash ^= zobrist.getEnPassantKey(enPassantSquare);
-  }
+  gamePly++;
+  st.halfmoveClock++;
+  st.pliesFromNull++;
 
-  // Handle captures
-  if (isCapture && !isEnPassant) {
-    zobristHash ^= zobrist.getPieceKey(toSquare, capturedPiece);
-    u64 capturedPieceLoc;
-    switch (capturedPiece) {
-    case WHITE_PAWN:
-      capturedPieceLoc = getWhitePawns();
-      capturedPieceLoc &= ~(Utils::squareToBitboard(toSquare));
-      setWhitePawns(capturedPieceLoc);
-      break;
-    case BLACK_PAWN:
-      capturedPieceLoc = getBlackPawns();
-      capturedPieceLoc &= ~(Utils::squareToBitboard(toSquare));
-      setBlackPawns(capturedPieceLoc);
-      break;
-    case WHITE_KNIGHT:
-      capturedPieceLoc = getWhiteKnights();
-      capturedPieceLoc &= ~(Utils::squareToBitboard(toSquare));
-      setWhiteKnights(capturedPieceLoc);
-      break;
-    case BLACK_KNIGHT:
-      capturedPieceLoc = getBlackKnights();
-      capturedPieceLoc &= ~(Utils::squareToBitboard(toSquare));
-      setBlackKnights(capturedPieceLoc);
-      break;
-    case WHITE_BISHOP:
-      capturedPieceLoc = getWhiteBishops();
-      capturedPieceLoc &= ~(Utils::squareToBitboard(toSquare));
-      setWhiteBishops(capturedPieceLoc);
-      break;
-    case BLACK_BISHOP:
-      capturedPieceLoc = getBlackBishops();
-      capturedPieceLoc &= ~(Utils::squareToBitboard(toSquare));
-      setBlackBishops(capturedPieceLoc);
-      break;
-    case WHITE_ROOK:
-      capturedPieceLoc = getWhiteRooks();
-      capturedPieceLoc &= ~(Utils::squareToBitboard(toSquare));
-      setWhiteRooks(capturedPieceLoc);
-      break;
-    case BLACK_ROOK:
-      capturedPieceLoc = getBlackRooks();
-      capturedPieceLoc &= ~(Utils::squareToBitboard(toSquare));
-      setBlackRooks(capturedPieceLoc);
-      break;
-    case WHITE_QUEEN:
-      capturedPieceLoc = getWhiteQueens();
-      capturedPieceLoc &= ~(Utils::squareToBitboard(toSquare));
-      setWhiteQueens(capturedPieceLoc);
-      break;
-    case BLACK_QUEEN:
-      capturedPieceLoc = getBlackQueens();
-      capturedPieceLoc &= ~(Utils::squareToBitboard(toSquare));
-      setBlackQueens(capturedPieceLoc);
-      break;
-    default:
-      break;
-    }
+  // Update Zobrist hash for en passant square
+  if (st.enPassantSquare != SQ_NONE) {
+    zobristHash ^= zobrist.getEnPassantKey(st.enPassantSquare);
   }
 
-  // Handle en passant
-  if (isEnPassant) {
-    if (piece == WHITE_PAWN) {
-      Square capturedPawnSquare = static_cast<Square>(toSquare - 8);
-      zobristHash ^= zobrist.getPieceKey(capturedPawnSquare, BLACK_PAWN);
-      u64 enemyPawns = getBlackPawns();
-      enemyPawns &= ~(Utils::squareToBitboard(capturedPawnSquare));
-      setBlackPawns(enemyPawns);
-      zobristHash ^= zobrist.getPieceKey(fromSquare, WHITE_PAWN);
-      zobristHash ^= zobrist.getPieceKey(toSquare, WHITE_PAWN);
-      u64 ownPawns = getWhitePawns();
-      ownPawns &= ~(Utils::squareToBitboard(fromSquare));
-      ownPawns |= Utils::squareToBitboard(toSquare);
-      setWhitePawns(ownPawns);
-    } else { // Black Pawn
-      Square capturedPawnSquare = static_cast<Square>(toSquare + 8);
-      zobristHash ^= zobrist.getPieceKey(capturedPawnSquare, WHITE_PAWN);
-      u64 enemyPawns = getWhitePawns();
-      enemyPawns &= ~(Utils::squareToBitboard(capturedPawnSquare));
-      setWhitePawns(enemyPawns);
-      zobristHash ^= zobrist.getPieceKey(fromSquare, BLACK_PAWN);
-      zobristHash ^= zobrist.getPieceKey(toSquare, BLACK_PAWN);
-      u64 ownPawns = getBlackPawns();
-      ownPawns &= ~(Utils::squareToBitboard(fromSquare));
-      ownPawns |= Utils::squareToBitboard(toSquare);
-      setBlackPawns(ownPawns);
-    }
-    moveHistory.push_back(move);
-    setALLPiecesAggregate();
-    zobristHash ^= zobrist.getBlackToMoveKey();
-    whiteToMove = !whiteToMove;
-    return;
+  // Handle captures; an en passant pawn sits behind the target square
+  Square captureSquare = toSquare;
+  if (move.getIsEnPassant())
+    captureSquare =
+        static_cast<Square>(piece == WHITE_PAWN ? toSquare - 8 : toSquare + 8);
+
+  st.capturedPiece = board[captureSquare];
+  bool isPawnMove = piece == WHITE_PAWN || piece == BLACK_PAWN;
+  if (isPawnMove || st.capturedPiece != EMPTY)
+    st.halfmoveClock = 0;
+
+  if (st.capturedPiece != EMPTY) {
+    PieceType captured = st.capturedPiece;
+    zobristHash ^= zobrist.getPieceKey(captureSquare, captured);
+    removePiece(captureSquare);
+    st.materialKey ^= zobrist.getMaterialKey(captured, getPieceCount(captured));
+    if (captured == WHITE_PAWN || captured == BLACK_PAWN)
+      st.pawnKey ^= zobrist.getPieceKey(captureSquare, captured);
   }
 
   // Move the piece
-  switch (piece) {
-  case WHITE_PAWN: {
-    zobristHash ^= zobrist.getPieceKey(fromSquare, WHITE_PAWN);
-    u64 whitePawnsLoc = getWhitePawns();
-    whitePawnsLoc &= ~(Utils::squareToBitboard(fromSquare));
-    if (isPromotion) {
-      PieceType promotedPiece = move.getPromotionPiece();
-      zobristHash ^= zobrist.getPieceKey(toSquare, promotedPiece);
-      switch (promotedPiece) {
-      case WHITE_QUEEN:
-        setWhiteQueens(getWhiteQueens() | Utils::squareToBitboard(toSquare));
-        break;
-      case WHITE_ROOK:
-        setWhiteRooks(getWhiteRooks() | Utils::squareToBitboard(toSquare));
-        break;
-      case WHITE_BISHOP:
-        setWhiteBishops(getWhiteBishops() | Utils::squareToBitboard(toSquare));
-        break;
-      case WHITE_KNIGHT:
-        setWhiteKnights(getWhiteKnights() | Utils::squareToBitboard(toSquare));
-        break;
-      default:
-        break;
-      }
-    } else {
-      zobristHash ^= zobrist.getPieceKey(toSquare, WHITE_PAWN);
-      whitePawnsLoc |= Utils::squareToBitboard(toSquare);
-    }
-    setWhitePawns(whitePawnsLoc);
-    break;
-  }
-  case BLACK_PAWN: {
-    zobristHash ^= zobrist.getPieceKey(fromSquare, BLACK_PAWN);
-    u64 blackPawnsLoc = getBlackPawns();
-    blackPawnsLoc &= ~(Utils::squareToBitboard(fromSquare));
-    if (isPromotion) {
-      PieceType promotedPiece = move.getPromotionPiece();
-      zobristHash ^= zobrist.getPieceKey(toSquare, promotedPiece);
-      switch (promotedPiece) {
-      case BLACK_QUEEN:
-        setBlackQueens(getBlackQueens() | Utils::squareToBitboard(toSquare));
-        break;
-      case BLACK_ROOK:
-        setBlackRooks(getBlackRooks() | Utils::squareToBitboard(toSquare));
-        break;
-      case BLACK_BISHOP:
-        setBlackBishops(getBlackBishops() | Utils::squareToBitboard(toSquare));
-        break;
-      case BLACK_KNIGHT:
-        setBlackKnights(getBlackKnights() | Utils::squareToBitboard(toSquare));
-        break;
-      default:
-        break;
-      }
-    } else {
-      zobristHash ^= zobrist.getPieceKey(toSquare, BLACK_PAWN);
-      blackPawnsLoc |= Utils::squareToBitboard(toSquare);
-    }
-    setBlackPawns(blackPawnsLoc);
-    break;
-  }
-  case WHITE_KNIGHT: {
-    zobristHash ^= zobrist.getPieceKey(fromSquare, WHITE_KNIGHT);
-    zobristHash ^= zobrist.getPieceKey(toSquare, WHITE_KNIGHT);
-    setWhiteKnights((getWhiteKnights() ^ Utils::squareToBitboard(fromSquare)) |
-                    Utils::squareToBitboard(toSquare));
-    break;
-  }
-  case BLACK_KNIGHT: {
-    zobristHash ^= zobrist.getPieceKey(fromSquare, BLACK_KNIGHT);
-    zobristHash ^= zobrist.getPieceKey(toSquare, BLACK_KNIGHT);
-    setBlackKnights((getBlackKnights() ^ Utils::squareToBitboard(fromSquare)) |
-                    Utils::squareToBitboard(toSquare));
-    break;
-  }
-  case WHITE_BISHOP: {
-    zobristHash ^= zobrist.getPieceKey(fromSquare, WHITE_BISHOP);
-    zobristHash ^= zobrist.getPieceKey(toSquare, WHITE_BISHOP);
-    setWhiteBishops((getWhiteBishops() ^ Utils::squareToBitboard(fromSquare)) |
-                    Utils::squareToBitboard(toSquare));
-    break;
-  }
-  case BLACK_BISHOP: {
-    zobristHash ^= zobrist.getPieceKey(fromSquare, BLACK_BISHOP);
-    zobristHash ^= zobrist.getPieceKey(toSquare, BLACK_BISHOP);
-    setBlackBishops((getBlackBishops() ^ Utils::squareToBitboard(fromSquare)) |
-                    Utils::squareToBitboard(toSquare));
-    break;
-  }
-  case WHITE_ROOK: {
-    zobristHash ^= zobrist.getPieceKey(fromSquare, WHITE_ROOK);
-    zobristHash ^= zobrist.getPieceKey(toSquare, WHITE_ROOK);
-    setWhiteRooks((getWhiteRooks() ^ Utils::squareToBitboard(fromSquare)) |
-                  Utils::squareToBitboard(toSquare));
-    break;
-  }
-  case BLACK_ROOK: {
-    zobristHash ^= zobrist.getPieceKey(fromSquare, BLACK_ROOK);
-    zobristHash ^= zobrist.getPieceKey(toSquare, BLACK_ROOK);
-    setBlackRooks((getBlackRooks() ^ Utils::squareToBitboard(fromSquare)) |
-                  Utils::squareToBitboard(toSquare));
-    break;
-  }
-  case WHITE_QUEEN: {
-    zobristHash ^= zobrist.getPieceKey(fromSquare, WHITE_QUEEN);
-    zobristHash ^= zobrist.getPieceKey(toSquare, WHITE_QUEEN);
-    setWhiteQueens((getWhiteQueens() ^ Utils::squareToBitboard(fromSquare)) |
-                   Utils::squareToBitboard(toSquare));
-    break;
+  zobristHash ^= zobrist.getPieceKey(fromSquare, piece);
+  zobristHash ^= zobrist.getPieceKey(toSquare, piece);
+  movePiece(piece, fromSquare, toSquare);
+  if (isPawnMove) {
+    st.pawnKey ^= zobrist.getPieceKey(fromSquare, piece);
+    st.pawnKey ^= zobrist.getPieceKey(toSquare, piece);
   }
-  case BLACK_QUEEN: {
-    zobristHash ^= zobrist.getPieceKey(fromSquare, BLACK_QUEEN);
-    zobristHash ^= zobrist.getPieceKey(toSquare, BLACK_QUEEN);
-    setBlackQueens((getBlackQueens() ^ Utils::squareToBitboard(fromSquare)) |
-                   Utils::squareToBitboard(toSquare));
-    break;
+
+  if (move.getIsPromotion()) {
+    PieceType promotedPiece = move.getPromotionPiece();
+    zobristHash ^= zobrist.getPieceKey(toSquare, piece);
+    zobristHash ^= zobrist.getPieceKey(toSquare, promotedPiece);
+    st.pawnKey ^= zobrist.getPieceKey(toSquare, piece);
+    removePiece(toSquare);
+    putPiece(promotedPiece, toSquare);
+    st.materialKey ^= zobrist.getMaterialKey(piece, getPieceCount(piece));
+    st.materialKey ^=
+        zobrist.getMaterialKey(promotedPiece, getPieceCount(promotedPiece) - 1);
   }
-  case WHITE_KING: {
-    zobristHash ^= zobrist.getPieceKey(fromSquare, WHITE_KING);
-    zobristHash ^= zobrist.getPieceKey(toSquare, WHITE_KING);
-    if (isKingSideCastling) {
-      zobristHash ^= zobrist.getPieceKey(H1, WHITE_ROOK);
-      zobristHash ^= zobrist.getPieceKey(F1, WHITE_ROOK);
-      setWhiteRooks((getWhiteRooks() ^ Utils::squareToBitboard(H1)) |
-                    Utils::squareToBitboard(F1));
-      hasWhiteCastled = true;
-    }
-    if (isQueenSideCastling) {
-      zobristHash ^= zobrist.getPieceKey(A1, WHITE_ROOK);
-      zobristHash ^= zobrist.getPieceKey(D1, WHITE_ROOK);
-      setWhiteRooks((getWhiteRooks() ^ Utils::squareToBitboard(A1)) |
-                    Utils::squareToBitboard(D1));
+
+  // Move the rook when castling
+  if (move.getIsKingSideCastle() || move.getIsQueenSideCastle()) {
+    bool kingSide = move.getIsKingSideCastle();
+    Square rookFrom =
+        static_cast<Square>(kingSide ? toSquare + 1 : toSquare - 2);
+    Square rookTo =
+        static_cast<Square>(kingSide ? toSquare - 1 : toSquare + 1);
+    PieceType rook = piece == WHITE_KING ? WHITE_ROOK : BLACK_ROOK;
+    zobristHash ^= zobrist.getPieceKey(rookFrom, rook);
+    zobristHash ^= zobrist.getPieceKey(rookTo, rook);
+    movePiece(rook, rookFrom, rookTo);
+    if (piece == WHITE_KING)
       hasWhiteCastled = true;
-    }
-    setWhiteKing((getWhiteKing() ^ Utils::squareToBitboard(fromSquare)) |
-                 Utils::squareToBitboard(toSquare));
-    break;
-  }
-  case BLACK_KING: {
-    zobristHash ^= zobrist.getPieceKey(fromSquare, BLACK_KING);
-    zobristHash ^= zobrist.getPieceKey(toSquare, BLACK_KING);
-    if (isKingSideCastling) {
-      zobristHash ^= zobrist.getPieceKey(H8, BLACK_ROOK);
-      zobristHash ^= zobrist.getPieceKey(F8, BLACK_ROOK);
-      setBlackRooks((getBlackRooks() ^ Utils::squareToBitboard(H8)) |
-                    Utils::squareToBitboard(F8));
-      hasBlackCastled = true;
-    }
-    if (isQueenSideCastling) {
-      zobristHash ^= zobrist.getPieceKey(A8, BLACK_ROOK);
-      zobristHash ^= zobrist.getPieceKey(D8, BLACK_ROOK);
-      setBlackRooks((getBlackRooks() ^ Utils::squareToBitboard(A8)) |
-                    Utils::squareToBitboard(D8));
+    else
       hasBlackCastled = true;
-    }
-    setBlackKing((getBlackKing() ^ Utils::squareToBitboard(fromSquare)) |
-                 Utils::squareToBitboard(toSquare));
-    break;
-  }
-  default:
-    break;
   }
 
-  moveHistory.push_back(move);
-  setALLPiecesAggregate();
-
-  // Update castling rights
-  if (piece == WHITE_KING) {
-    canWhiteCastleKS = false;
-    canWhiteCastleQS = false;
-  } else if (piece == BLACK_KING) {
-    canBlackCastleKS = false;
-    canBlackCastleQS = false;
+  // Update castling rights and their Zobrist key
+  int newCastlingRights = st.castlingRights & castlingRightsMask[fromSquare] &
+                          castlingRightsMask[toSquare];
+  if (newCastlingRights != st.castlingRights) {
+    zobristHash ^= zobrist.getCastleKey(st.castlingRights);
+    zobristHash ^= zobrist.getCastleKey(newCastlingRights);
+    st.castlingRights = newCastlingRights;
   }
-  if (fromSquare == H1 || toSquare == H1)
-    canWhiteCastleKS = false;
-  if (fromSquare == A1 || toSquare == A1)
-    canWhiteCastleQS = false;
-  if (fromSquare == H8 || toSquare == H8)
-    canBlackCastleKS = false;
-  if (fromSquare == A8 || toSquare == A8)
-    canBlackCastleQS = false;
-
-  // Update Zobrist hash for castling rights
-  int newCastlingRights =
-      (canWhiteCastleKS ? 1 : 0) | (canWhiteCastleQS ? 2 : 0) |
-      (canBlackCastleKS ? 4 : 0) | (canBlackCastleQS ? 8 : 0);
-  zobristHash ^= zobrist.getCastleKey(oldCastlingRights);
-  zobristHash ^= zobrist.getCastleKey(newCastlingRights);
 
   // Update en passant square and Zobrist hash
   if ((piece == WHITE_PAWN || piece == BLACK_PAWN) &&
       abs(toSquare - fromSquare) == 16) {
-    enPassantSquare = static_cast<Square>((fromSquare + toSquare) / 2);
-    zobristHash ^= zobrist.getEnPassantKey(enPassantSquare);
+    st.enPassantSquare = static_cast<Square>((fromSquare + toSquare) / 2);
+    zobristHash ^= zobrist.getEnPassantKey(st.enPassantSquare);
   } else {
-    enPassantSquare = SQ_NONE;
+    st.enPassantSquare = SQ_NONE;
   }
 
   // Switch side to move and update Zobrist hash
   zobristHash ^= zobrist.getBlackToMoveKey();
   whiteToMove = !whiteToMove;
+
+  updateCheckInfo();
 }
 
 // Reverts the last move made on the board
 void Board::undoMove() {
-  undoInfo undo = stateHistory.back();
-  stateHistory.pop_back();
-
-  Move move = undo.move;
+  historyPly--;
+  const Move &move = moveStack[historyPly];
   Square fromSquare = move.getFromSquare();
   Square toSquare = move.getToSquare();
-  PieceType piece = move.getPieceType();
-  PieceType capturedPiece = undo.capturedPiece;
-  bool isCapture = move.getIsCapture();
-  bool isPromotion = move.getIsPromotion();
-  bool isEnPassant = move.getIsEnPassant();
-  bool isKingSideCastling = move.getIsKingSideCastle();
-  bool isQueenSideCastling = move.getIsQueenSideCastle();
-
-  // Restore board state from undoInfo
-  whiteToMove = undo.whiteToMove;
-  enPassantSquare = undo.enPassantSquare;
-  canWhiteCastleKS = undo.canWhiteCastleKS;
-  canWhiteCastleQS = undo.canWhiteCastleQS;
-  canBlackCastleKS = undo.canBlackCastleKS;
-  canBlackCastleQS = undo.canBlackCastleQS;
-  hasWhiteCastled = undo.hasWhiteCastled;
-  hasBlackCastled = undo.hasBlackCastled;
-  zobristHash = undo.zobristHash;
-
-  moveHistory.pop_back();
-
-  u64 currPieceLoc = 0ULL;
-  u64 capturedPieceLoc = 0ULL;
-
-  // Handle en passant undo
-  if (isEnPassant) {
-    if (piece == WHITE_PAWN) {
-      u64 ownPawns = getWhitePawns();
-      ownPawns &= ~(Utils::squareToBitboard(toSquare));
-      ownPawns |= Utils::squareToBitboard(fromSquare);
-      setWhitePawns(ownPawns);
-
-      Square capturedPawnSquare = static_cast<Square>(toSquare - 8);
-      u64 enemyPawns = getBlackPawns();
-      enemyPawns |= Utils::squareToBitboard(capturedPawnSquare);
-      setBlackPawns(enemyPawns);
-
-      setALLPiecesAggregate();
-      return;
-    } else {
-      u64 ownPawns = getBlackPawns();
-      ownPawns &= ~(Utils::squareToBitboard(toSquare));
-      ownPawns |= Utils::squareToBitboard(fromSquare);
-      setBlackPawns(ownPawns);
-
-      Square capturedPawnSquare = static_cast<Square>(toSquare + 8);
-      u64 enemyPawns = getWhitePawns();
-      enemyPawns |= Utils::squareToBitboard(capturedPawnSquare);
-      setWhitePawns(enemyPawns);
-
-      setALLPiecesAggregate();
-      return;
-    }
+  PieceType capturedPiece = st.capturedPiece;
+
+  // Restore the state saved by makeMove
+  st = stateStack[historyPly];
+  whiteToMove = !whiteToMove;
+  gamePly--;
+
+  // The moved piece now stands on the destination, unless it promoted
+  PieceType piece =
+      move.getIsPromotion()
+          ? makePiece(whiteToMove ? WHITE : BLACK, PAWN)
+          : board[toSquare];
+
+  // Put the rook back; a castling move is always the side's only one
+  if (move.getIsKingSideCastle() || move.getIsQueenSideCastle()) {
+    bool kingSide = move.getIsKingSideCastle();
+    Square rookFrom =
+        static_cast<Square>(kingSide ? toSquare + 1 : toSquare - 2);
+    Square rookTo =
+        static_cast<Square>(kingSide ? toSquare - 1 : toSquare + 1);
+    movePiece(piece == WHITE_KING ? WHITE_ROOK : BLACK_ROOK, rookTo, rookFrom);
+    if (piece == WHITE_KING)
+      hasWhiteCastled = false;
+    else
+      hasBlackCastled = false;
   }
 
-  // Move the piece back
-  switch (piece) {
-  case EMPTY:
-    break;
-  case WHITE_PAWN:
-    currPieceLoc = getWhitePawns();
-    if (isPromotion) {
-      PieceType promotedPiece = move.getPromotionPiece();
-
-      switch (promotedPiece) {
-      case WHITE_QUEEN: {
-        u64 promoPieces = getWhiteQueens();
-        promoPieces &= ~(Utils::squareToBitboard(toSquare));
-        setWhiteQueens(promoPieces);
-        break;
-      }
-      case WHITE_ROOK: {
-        u64 promoPieces = getWhiteRooks();
-        promoPieces &= ~(Utils::squareToBitboard(toSquare));
-        setWhiteRooks(promoPieces);
-        break;
-      }
-      case WHITE_BISHOP: {
-        u64 promoPieces = getWhiteBishops();
-        promoPieces &= ~(Utils::squareToBitboard(toSquare));
-        setWhiteBishops(promoPieces);
-        break;
-      }
-      case WHITE_KNIGHT: {
-        u64 promoPieces = getWhiteKnights();
-        promoPieces &= ~(Utils::squareToBitboard(toSquare));
-        setWhiteKnights(promoPieces);
-        break;
-      }
-      default:
-        break;
-      }
-      currPieceLoc |= Utils::squareToBitboard(fromSquare);
-    } else {
-      currPieceLoc &= ~(Utils::squareToBitboard(toSquare));
-      currPieceLoc |= Utils::squareToBitboard(fromSquare);
-    }
-    setWhitePawns(currPieceLoc);
-    break;
-
-  case BLACK_PAWN:
-    currPieceLoc = getBlackPawns();
-    if (isPromotion) {
-      PieceType promotedPiece = move.getPromotionPiece();
-
-      switch (promotedPiece) {
-      case BLACK_QUEEN: {
-        u64 promoPieces = getBlackQueens();
-        promoPieces &= ~(Utils::squareToBitboard(toSquare));
-        setBlackQueens(promoPieces);
-        break;
-      }
-      case BLACK_ROOK: {
-        u64 promoPieces = getBlackRooks();
-        promoPieces &= ~(Utils::squareToBitboard(toSquare));
-        setBlackRooks(promoPieces);
-        break;
-      }
-      case BLACK_BISHOP: {
-        u64 promoPieces = getBlackBishops();
-        promoPieces &= ~(Utils::squareToBitboard(toSquare));
-        setBlackBishops(promoPieces);
-        break;
-      }
-      case BLACK_KNIGHT: {
-        u64 promoPieces = getBlackKnights();
-        promoPieces &= ~(Utils::squareToBitboard(toSquare));
-        setBlackKnights(promoPieces);
-        break;
-      }
-      default:
-        break;
-      }
-      currPieceLoc |= Utils::squareToBitboard(fromSquare);
-    } else {
-      currPieceLoc &= ~(Utils::squareToBitboard(toSquare));
-      currPieceLoc |= Utils::squareToBitboard(fromSquare);
-    }
-    setBlackPawns(currPieceLoc);
-    break;
-
-  case WHITE_KNIGHT:
-    currPieceLoc = getWhiteKnights();
-    currPieceLoc &= ~(Utils::squareToBitboard(toSquare));
-    currPieceLoc |= Utils::squareToBitboard(fromSquare);
-    setWhiteKnights(currPieceLoc);
-    break;
-
-  case BLACK_KNIGHT:
-    currPieceLoc = getBlackKnights();
-    currPieceLoc &= ~(Utils::squareToBitboard(toSquare));
-    currPieceLoc |= Utils::squareToBitboard(fromSquare);
-    setBlackKnights(currPieceLoc);
-
-    break;
-
-  case WHITE_BISHOP:
-    currPieceLoc = getWhiteBishops();
-    currPieceLoc &= ~(Utils::squareToBitboard(toSquare));
-    currPieceLoc |= Utils::squareToBitboard(fromSquare);
-    setWhiteBishops(currPieceLoc);
-    break;
-
-  case BLACK_BISHOP:
-    currPieceLoc = getBlackBishops();
-    currPieceLoc &= ~(Utils::squareToBitboard(toSquare));
-    currPieceLoc |= Utils::squareToBitboard(fromSquare);
-    setBlackBishops(currPieceLoc);
-    break;
-
-  case WHITE_ROOK:
-    currPieceLoc = getWhiteRooks();
-    currPieceLoc &= ~(Utils::squareToBitboard(toSquare));
-    currPieceLoc |= Utils::squareToBitboard(fromSquare);
-    setWhiteRooks(currPieceLoc);
-    break;
-  case BLACK_ROOK:
-    currPieceLoc = getBlackRooks();
-    currPieceLoc &= ~(Utils::squareToBitboard(toSquare));
-    currPieceLoc |= Utils::squareToBitboard(fromSquare);
-    setBlackRooks(currPieceLoc);
-    break;
-
-  case WHITE_QUEEN:
-    currPieceLoc = getWhiteQueens();
-    currPieceLoc &= ~(Utils::squareToBitboard(toSquare));
-    currPieceLoc |= Utils::squareToBitboard(fromSquare);
-    setWhiteQueens(currPieceLoc);
-    break;
-
-  case BLACK_QUEEN:
-    currPieceLoc = getBlackQueens();
-    currPieceLoc &= ~(Utils::squareToBitboard(toSquare));
-    currPieceLoc |= Utils::squareToBitboard(fromSquare);
-    setBlackQueens(currPieceLoc);
-    break;
-  case WHITE_KING:
-    currPieceLoc = getWhiteKing();
-    currPieceLoc &= ~(Utils::squareToBitboard(toSquare));
-    currPieceLoc |= Utils::squareToBitboard(fromSquare);
-    setWhiteKing(currPieceLoc);
-
-    if (isKingSideCastling) {
-      u64 rookloc = getWhiteRooks();
-      rookloc &= ~(Utils::squareToBitboard(F1));
-      rookloc |= Utils::squareToBitboard(H1);
-      setWhiteRooks(rookloc);
-    }
-    if (isQueenSideCastling) {
-      u64 rookloc = getWhiteRooks();
-      rookloc &= ~(Utils::squareToBitboard(D1));
-      rookloc |= Utils::squareToBitboard(A1);
-      setWhiteRooks(rookloc);
-    }
-    break;
-
-  case BLACK_KING:
-    currPieceLoc = getBlackKing();
-    currPieceLoc &= ~(Utils::squareToBitboard(toSquare));
-    currPieceLoc |= Utils::squareToBitboard(fromSquare);
-    setBlackKing(currPieceLoc);
-
-    // Reverse castling rook moves
-    if (isKingSideCastling) {
-      u64 rookloc = getBlackRooks();
-      rookloc &= ~(Utils::squareToBitboard(F8));
-      rookloc |= Utils::squareToBitboard(H8);
-      setBlackRooks(rookloc);
-    }
-    if (isQueenSideCastling) {
-      u64 rookloc = getBlackRooks();
-      rookloc &= ~(Utils::squareToBitboard(D8));
-      rookloc |= Utils::squareToBitboard(A8);
-      setBlackRooks(rookloc);
-    }
-    break;
+  // Turn a promoted piece back into the pawn
+  if (move.getIsPromotion()) {
+    removePiece(toSquare);
+    putPiece(piece, toSquare);
   }
 
+  // Move the piece back
+  movePiece(piece, toSquare, fromSquare);
+
   // Restore the captured piece
-  if (isCapture && capturedPiece != EMPTY) {
-    switch (capturedPiece) {
-    case WHITE_PAWN:
-      capturedPieceLoc = getWhitePawns();
-      capturedPieceLoc |= Utils::squareToBitboard(toSquare);
-      setWhitePawns(capturedPieceLoc);
-      break;
-    case BLACK_PAWN:
-      capturedPieceLoc = getBlackPawns();
-      capturedPieceLoc |= Utils::squareToBitboard(toSquare);
-      setBlackPawns(capturedPieceLoc);
-      break;
-    case WHITE_KNIGHT:
-      capturedPieceLoc = getWhiteKnights();
-      capturedPieceLoc |= Utils::squareToBitboard(toSquare);
-      setWhiteKnights(capturedPieceLoc);
-      break;
-    case BLACK_KNIGHT:
-      capturedPieceLoc = getBlackKnights();
-      capturedPieceLoc |= Utils::squareToBitboard(toSquare);
-      setBlackKnights(capturedPieceLoc);
-      break;
-    case WHITE_BISHOP:
-      capturedPieceLoc = getWhiteBishops();
-      capturedPieceLoc |= Utils::squareToBitboard(toSquare);
-      setWhiteBishops(capturedPieceLoc);
-      break;
-    case BLACK_BISHOP:
-      capturedPieceLoc = getBlackBishops();
-      capturedPieceLoc |= Utils::squareToBitboard(toSquare);
-      setBlackBishops(capturedPieceLoc);
-      break;
-    case WHITE_ROOK:
-      capturedPieceLoc = getWhiteRooks();
-      capturedPieceLoc |= Utils::squareToBitboard(toSquare);
-      setWhiteRooks(capturedPieceLoc);
-      break;
-    case BLACK_ROOK:
-      capturedPieceLoc = getBlackRooks();
-      capturedPieceLoc |= Utils::squareToBitboard(toSquare);
-      setBlackRooks(capturedPieceLoc);
-      break;
-    case WHITE_QUEEN:
-      capturedPieceLoc = getWhiteQueens();
-      capturedPieceLoc |= Utils::squareToBitboard(toSquare);
-      setWhiteQueens(capturedPieceLoc);
-      break;
-    case BLACK_QUEEN:
-      capturedPieceLoc = getBlackQueens();
-      capturedPieceLoc |= Utils::squareToBitboard(toSquare);
-      setBlackQueens(capturedPieceLoc);
-      break;
-    default:
-      break;
-    }
+  if (capturedPiece != EMPTY) {
+    Square captureSquare = toSquare;
+    if (move.getIsEnPassant())
+      captureSquare = static_cast<Square>(piece == WHITE_PAWN ? toSquare - 8
+                                                              : toSquare + 8);
+    putPiece(capturedPiece, captureSquare);
   }
+}
 
-  setALLPiecesAggregate();
+// Keeps only the newest 'keep' plies of history. Those still cover every
+// position that can repeat, since a longer reversible run is already a draw
+// by the fifty-move rule; the dropped moves can no longer be undone.
+void Board::dropOldHistory(int keep) {
+  int drop = historyPly - keep;
+  std::copy(stateStack + drop, stateStack + historyPly, stateStack);
+  std::copy(moveStack + drop, moveStack + historyPly, moveStack);
+  historyPly = keep;
 }
 
-int Board::getAttackersCount(bool isWhite) {
+void Board::trimHistory() {
+  if (historyPly > MAX_GAME_PLY)
+    dropOldHistory(MAX_GAME_PLY / 2);
+}
 
-  u64 kingLoc = isWhite ? getWhiteKing() : getBlackKing();
+// Passes the turn, keeping only the state needed to take it back
+void Board::makeNullMove() {
+  if (historyPly == STATE_STACK_SIZE)
+    dropOldHistory(STATE_STACK_SIZE / 2);
+  stateStack[historyPly] = st;
+  moveStack[historyPly] = Move();
+  historyPly++;
+
+  st.capturedPiece = EMPTY;
+  st.halfmoveClock++;
+  st.pliesFromNull = 0;
+  if (st.enPassantSquare != SQ_NONE) {
+    st.zobristHash ^= zobrist.getEnPassantKey(st.enPassantSquare);
+    st.enPassantSquare = SQ_NONE;
+  }
 
-  u64 enemyPawnAttacks = isWhite
-                             ? validMoveBB::blackPawnAttacks(getBlackPawns())
-                             : validMoveBB::whitePawnAttacks(getWhitePawns());
-
-  u64 enemyKnightAttacks =
-      isWhite
-          ? validMoveBB::knightMoves(getBlackKnights(), getAllBlackPieces())
-          : validMoveBB::knightMoves(getWhiteKnights(), getAllWhitePieces());
-
-  u64 enemyBishopAttacks =
-      isWhite ? validMoveBB::bishopMoves(getBlackBishops(), getAllBlackPieces(),
-                                         getAllWhitePieces())
-              : validMoveBB::bishopMoves(getWhiteBishops(), getAllWhitePieces(),
-                                         getAllBlackPieces());
-
-  u64 enemyRookAttacks =
-      isWhite ? validMoveBB::rookMoves(getBlackRooks(), getAllBlackPieces(),
-                                       getAllWhitePieces())
-              : validMoveBB::rookMoves(getWhiteRooks(), getAllWhitePieces(),
-                                       getAllBlackPieces());
-
-  u64 enemyQueenAttacks =
-      isWhite ? validMoveBB::queenMoves(getBlackQueens(), getAllBlackPieces(),
-                                        getAllWhitePieces())
-              : validMoveBB::queenMoves(getWhiteQueens(), getAllWhitePieces(),
-                                        getAllBlackPieces());
-
-  int count = 0;
-
-  if (kingLoc & enemyPawnAttacks)
-    count++;
-  if (kingLoc & enemyKnightAttacks)
-    count++;
-  if (kingLoc & enemyBishopAttacks)
-    count++;
-  if (kingLoc & enemyRookAttacks)
-    count++;
-  if (kingLoc & enemyQueenAttacks)
-    count++;
-
-  return count;
+  st.zobristHash ^= zobrist.getBlackToMoveKey();
+  whiteToMove = !whiteToMove;
+
+  // Nothing moved, so the king blockers still hold and the new side to move
+  // cannot be in check
+  st.checkers = 0ULL;
+  updateCheckSquares();
+}
+
+// Reverts the last null move
+void Board::undoNullMove() {
+  historyPly--;
+  st = stateStack[historyPly];
+  whiteToMove = !whiteToMove;
+}
+
+// Checks for a draw by the fifty-move rule or by repetition
+bool Board::isDraw(int ply) {
+  // A mate delivered on the hundredth reversible ply still counts as mate
+  if (st.halfmoveClock >= 100) {
+    if (!st.checkers)
+      return true;
+    MoveList evasions;
+    MoveGeneration::generateEvasions(*this, evasions);
+    return !evasions.empty();
+  }
+
+  // Only positions since the last irreversible move (or null move) can repeat,
+  // and only those with the same side to move
+  int end = std::min(std::min(st.halfmoveClock, st.pliesFromNull), historyPly);
+  int repetitions = 0;
+  for (int i = 4; i <= end; i += 2) {
+    if (stateStack[historyPly - i].zobristHash == st.zobristHash) {
+      if (i < ply || ++repetitions == 2)
+        return true;
+    }
+  }
+  return false;
+}
+
+int Board::getAttackersCount(bool isWhite) {
+  if (isWhite == whiteToMove)
+    return Utils::popcount(st.checkers);
+
+  Color us = isWhite ? WHITE : BLACK;
+  u64 king = pieces[us][KING];
+  if (!king)
+    return 0;
+  return Utils::popcount(attackersTo(Utils::bitboardToSquare(king), allPieces) &
+                         occupancy[~us]);
 }
 
 bool Board::canCastleKingSide(bool isWhite) {
   // Check FEN castling rights first
-  bool hasCastleRights = isWhite ? canWhiteCastleKS : canBlackCastleKS;
+  bool hasCastleRights = st.castlingRights & (isWhite ? WHITE_KS : BLACK_KS);
   if (!hasCastleRights)
     return false;
 
@@ -811,15 +404,16 @@ bool Board::canCastleKingSide(bool isWhite) {
     return false;
 
   // Check if squares between king and rook are clear and not attacked
-  u64 enemyAttacks = validMoveBB::allEnemyAttacks(*this, !isWhite);
+  u64 enemies = occupancy[isWhite ? BLACK : WHITE];
   u64 blockers = getAllWhitePieces() | getAllBlackPieces();
 
   if (isWhite) {
     u64 F1_square = Utils::squareToBitboard(F1);
     u64 G1_square = Utils::squareToBitboard(G1);
 
-    if ((enemyAttacks & F1_square) != 0 || (enemyAttacks & G1_square) != 0 ||
-        (blockers & F1_square) != 0 || (blockers & G1_square) != 0)
+    if ((blockers & F1_square) != 0 || (blockers & G1_square) != 0 ||
+        (attackersTo(F1, blockers) & enemies) != 0 ||
+        (attackersTo(G1, blockers) & enemies) != 0)
       return false;
 
     return true;
@@ -827,8 +421,9 @@ bool Board::canCastleKingSide(bool isWhite) {
     u64 F8_square = Utils::squareToBitboard(F8);
     u64 G8_square = Utils::squareToBitboard(G8);
 
-    if ((enemyAttacks & F8_square) != 0 || (enemyAttacks & G8_square) != 0 ||
-        (blockers & F8_square) != 0 || (blockers & G8_square) != 0)
+    if ((blockers & F8_square) != 0 || (blockers & G8_square) != 0 ||
+        (attackersTo(F8, blockers) & enemies) != 0 ||
+        (attackersTo(G8, blockers) & enemies) != 0)
       return false;
 
     return true;
@@ -837,7 +432,7 @@ bool Board::canCastleKingSide(bool isWhite) {
 
 bool Board::canCastleQueenSide(bool isWhite) {
   // Check FEN castling rights first
-  bool hasCastleRights = isWhite ? canWhiteCastleQS : canBlackCastleQS;
+  bool hasCastleRights = st.castlingRights & (isWhite ? WHITE_QS : BLACK_QS);
   if (!hasCastleRights)
     return false;
 
@@ -858,7 +453,7 @@ bool Board::canCastleQueenSide(bool isWhite) {
     return false;
 
   // Check if squares between king and rook are clear and not attacked
-  u64 enemyAttacks = validMoveBB::allEnemyAttacks(*this, !isWhite);
+  u64 enemies = occupancy[isWhite ? BLACK : WHITE];
   u64 blockers = getAllWhitePieces() | getAllBlackPieces();
 
   if (isWhite) {
@@ -866,9 +461,10 @@ bool Board::canCastleQueenSide(bool isWhite) {
     u64 C1_square = Utils::squareToBitboard(C1);
     u64 B1_square = Utils::squareToBitboard(B1);
 
-    if ((enemyAttacks & D1_square) != 0 || (enemyAttacks & C1_square) != 0 ||
-        (blockers & D1_square) != 0 || (blockers & C1_square) != 0 ||
-        (blockers & B1_square) != 0)
+    if ((blockers & D1_square) != 0 || (blockers & C1_square) != 0 ||
+        (blockers & B1_square) != 0 ||
+        (attackersTo(D1, blockers) & enemies) != 0 ||
+        (attackersTo(C1, blockers) & enemies) != 0)
       return false;
 
     return true;
@@ -877,28 +473,28 @@ bool Board::canCastleQueenSide(bool isWhite) {
     u64 C8_square = Utils::squareToBitboard(C8);
     u64 B8_square = Utils::squareToBitboard(B8);
 
-    if ((enemyAttacks & D8_square) != 0 || (enemyAttacks & C8_square) != 0 ||
-        (blockers & D8_square) != 0 || (blockers & C8_square) != 0 ||
-        (blockers & B8_square) != 0)
+    if ((blockers & D8_square) != 0 || (blockers & C8_square) != 0 ||
+        (blockers & B8_square) != 0 ||
+        (attackersTo(D8, blockers) & enemies) != 0 ||
+        (attackersTo(C8, blockers) & enemies) != 0)
       return false;
 
     return true;
   }
 }
 
-void Board::loadFromFen(const std::string &fen) {
+void Board::loadFromFen(std::string_view fen) {
 
   // Clear all bitboards first
-  whitePawns = whiteKnights = whiteBishops = whiteRooks = whiteQueens =
-      whiteKing = 0;
-  blackPawns = blackKnights = blackBishops = blackRooks = blackQueens =
-      blackKing = 0;
+  std::fill(&pieces[0][0], &pieces[0][0] + 12, 0ULL);
+  std::fill(std::begin(occupancy), std::end(occupancy), 0ULL);
+  allPieces = 0ULL;
+  std::fill(std::begin(board), std::end(board), EMPTY);
 
-  std::istringstream ss(fen);
-  std::string token;
+  size_t pos = 0;
 
   // 1. Parse piece placement
-  std::getline(ss, token, ' ');
+  std::string_view token = nextFenField(fen, pos);
   int rank = 7; // Start from rank 8 (index 7)
   int file = 0; // Start from file a (index 0)
 
@@ -906,160 +502,290 @@ void Board::loadFromFen(const std::string &fen) {
     if (c == '/') {
       rank--;
       file = 0;
-    } else if (std::isdigit(c)) {
+    } else if (c >= '1' && c <= '8') {
       file += (c - '0');
     } else {
-      Square sq = static_cast<Square>(rank * 8 + file);
       PieceType piece = Utils::charToPiece(c);
-      u64 bitboard = Utils::squareToBitboard(sq);
-
-      switch (piece) {
-      case WHITE_PAWN:
-        whitePawns |= bitboard;
-        break;
-      case BLACK_PAWN:
-        blackPawns |= bitboard;
-        break;
-      case WHITE_KNIGHT:
-        whiteKnights |= bitboard;
-        break;
-      case BLACK_KNIGHT:
-        blackKnights |= bitboard;
-        break;
-      case WHITE_BISHOP:
-        whiteBishops |= bitboard;
-        break;
-      case BLACK_BISHOP:
-        blackBishops |= bitboard;
-        break;
-      case WHITE_ROOK:
-        whiteRooks |= bitboard;
-        break;
-      case BLACK_ROOK:
-        blackRooks |= bitboard;
-        break;
-      case WHITE_QUEEN:
-        whiteQueens |= bitboard;
-        break;
-      case BLACK_QUEEN:
-        blackQueens |= bitboard;
-        break;
-      case WHITE_KING:
-        whiteKing |= bitboard;
-        break;
-      case BLACK_KING:
-        blackKing |= bitboard;
-        break;
-      default:
-        break;
-      }
+      if (piece != EMPTY && rank >= 0 && file < 8)
+        putPiece(piece, Utils::makeSquare(rank, file));
       file++;
     }
   }
 
   // 2. Parse active color
-  std::getline(ss, token, ' ');
+  token = nextFenField(fen, pos);
   whiteToMove = (token == "w");
 
   // 3. Parse castling rights
-  std::getline(ss, token, ' ');
-  canWhiteCastleKS = (token.find('K') != std::string::npos);
-  canWhiteCastleQS = (token.find('Q') != std::string::npos);
-  canBlackCastleKS = (token.find('k') != std::string::npos);
-  canBlackCastleQS = (token.find('q') != std::string::npos);
+  token = nextFenField(fen, pos);
+  st.castlingRights = NO_CASTLING;
+  for (char c : token) {
+    switch (c) {
+    case 'K':
+      st.castlingRights |= WHITE_KS;
+      break;
+    case 'Q':
+      st.castlingRights |= WHITE_QS;
+      break;
+    case 'k':
+      st.castlingRights |= BLACK_KS;
+      break;
+    case 'q':
+      st.castlingRights |= BLACK_QS;
+      break;
+    default:
+      break;
+    }
+  }
 
   // 4. Parse en passant target square
-  std::getline(ss, token, ' ');
-  if (token == "-") {
-    enPassantSquare = SQ_NONE;
+  token = nextFenField(fen, pos);
+  st.enPassantSquare = Utils::stringToSquare(token);
+
+  // 5. Parse halfmove clock and fullmove number, which are optional
+  int fullmoveNumber = 1;
+  st.halfmoveClock = 0;
+  token = nextFenField(fen, pos);
+  std::from_chars(token.data(), token.data() + token.size(), st.halfmoveClock);
+  token = nextFenField(fen, pos);
+  std::from_chars(token.data(), token.data() + token.size(), fullmoveNumber);
+  fullmoveNumber = std::max(1, fullmoveNumber);
+  gamePly = 2 * (fullmoveNumber - 1) + (whiteToMove ? 0 : 1);
+
+  st.capturedPiece = EMPTY;
+  st.pliesFromNull = 0;
+  historyPly = 0;
+
+  updateCheckInfo();
+  initZobristHash();
+}
+
+// Writes the position as a FEN string
+int Position::toFen(char *out) const {
+  char *p = out;
+
+  // 1. Piece placement, from rank 8 down to rank 1
+  for (int rank = 7; rank >= 0; rank--) {
+    int emptySquares = 0;
+    for (int file = 0; file < 8; file++) {
+      PieceType piece = board[rank * 8 + file];
+      if (piece == EMPTY) {
+        emptySquares++;
+        continue;
+      }
+      if (emptySquares) {
+        *p++ = static_cast<char>('0' + emptySquares);
+        emptySquares = 0;
+      }
+      *p++ = pieceChars[piece];
+    }
+    if (emptySquares)
+      *p++ = static_cast<char>('0' + emptySquares);
+    if (rank > 0)
+      *p++ = '/';
+  }
+
+  // 2. Active color
+  *p++ = ' ';
+  *p++ = whiteToMove ? 'w' : 'b';
+
+  // 3. Castling rights
+  *p++ = ' ';
+  if (st.castlingRights == NO_CASTLING)
+    *p++ = '-';
+  if (st.castlingRights & WHITE_KS)
+    *p++ = 'K';
+  if (st.castlingRights & WHITE_QS)
+    *p++ = 'Q';
+  if (st.castlingRights & BLACK_KS)
+    *p++ = 'k';
+  if (st.castlingRights & BLACK_QS)
+    *p++ = 'q';
+
+  // 4. En passant target square
+  *p++ = ' ';
+  if (st.enPassantSquare == SQ_NONE) {
+    *p++ = '-';
   } else {
-    enPassantSquare = Utils::stringToSquare(token);
+    *p++ = static_cast<char>('a' + st.enPassantSquare % 8);
+    *p++ = static_cast<char>('1' + st.enPassantSquare / 8);
   }
 
-  // Update aggregate bitboards
-  setALLPiecesAggregate();
+  // 5. Halfmove clock and fullmove number
+  char *end = out + MAX_FEN_LENGTH - 1;
+  *p++ = ' ';
+  p = std::to_chars(p, end, st.halfmoveClock).ptr;
+  *p++ = ' ';
+  p = std::to_chars(p, end, getFullmoveNumber()).ptr;
+
+  *p = '\0';
+  return static_cast<int>(p - out);
 }
 
-// Detects pieces that are pinned to the king
-u64 Board::getPinnedPieces(bool isWhite) {
-  u64 pinned = 0ULL;
-  u64 kingLoc = isWhite ? getWhiteKing() : getBlackKing();
-  Square kingSquare = Utils::bitboardToSquare(kingLoc);
+// Packs the position into 32 bytes
+PackedPosition Position::encode() const {
+  PackedPosition packed = {};
+  packed.occupied = allPieces;
+
+  int index = 0;
+  u64 occupied = allPieces;
+  while (occupied && index < 32) {
+    Square sq = Utils::popLSB(occupied);
+    packed.pieceCodes[index / 2] |= board[sq] << (4 * (index % 2));
+    index++;
+  }
 
-  u64 ownPieces = isWhite ? getAllWhitePieces() : getAllBlackPieces();
-  u64 enemyPieces = isWhite ? getAllBlackPieces() : getAllWhitePieces();
+  packed.whiteToMove = whiteToMove;
+  packed.castlingRights = static_cast<uint8_t>(st.castlingRights);
+  packed.enPassantFile =
+      st.enPassantSquare == SQ_NONE ? 8 : st.enPassantSquare % 8;
+  packed.halfmoveClock = static_cast<uint8_t>(std::min(st.halfmoveClock, 255));
+  packed.fullmoveNumber = static_cast<uint16_t>(getFullmoveNumber());
+  return packed;
+}
 
-  // Check for pins from diagonal sliders (bishops and queens)
-  u64 enemyDiagonalSliders = isWhite ? (getBlackBishops() | getBlackQueens())
-                                     : (getWhiteBishops() | getWhiteQueens());
+// Loads a packed position, replacing the current one and its history
+void Board::decode(const PackedPosition &packed) {
+  std::fill(&pieces[0][0], &pieces[0][0] + 12, 0ULL);
+  std::fill(std::begin(occupancy), std::end(occupancy), 0ULL);
+  allPieces = 0ULL;
+  std::fill(std::begin(board), std::end(board), EMPTY);
+
+  int index = 0;
+  u64 occupied = packed.occupied;
+  while (occupied && index < 32) {
+    Square sq = Utils::popLSB(occupied);
+    int code = (packed.pieceCodes[index / 2] >> (4 * (index % 2))) & 0xF;
+    if (code >= WHITE_PAWN && code <= BLACK_KING)
+      putPiece(static_cast<PieceType>(code), sq);
+    index++;
+  }
 
-  while (enemyDiagonalSliders) {
-    Square attackerSq = Utils::popLSB(enemyDiagonalSliders);
-    u64 attacker = Utils::squareToBitboard(attackerSq);
+  whiteToMove = packed.whiteToMove != 0;
+  st.castlingRights = packed.castlingRights & ALL_CASTLING;
+  st.enPassantSquare =
+      packed.enPassantFile < 8
+          ? Utils::makeSquare(whiteToMove ? 5 : 2, packed.enPassantFile)
+          : SQ_NONE;
+  st.halfmoveClock = packed.halfmoveClock;
+  st.capturedPiece = EMPTY;
+  st.pliesFromNull = 0;
+  gamePly = 2 * (std::max<int>(packed.fullmoveNumber, 1) - 1) +
+            (whiteToMove ? 0 : 1);
+  historyPly = 0;
+
+  updateCheckInfo();
+  initZobristHash();
+}
 
-    u64 fullRay = validMoveBB::bishopMoves(attacker, 0ULL, 0ULL);
-    if ((fullRay & kingLoc) == 0)
-      continue;
+// Returns the pieces of the given color that are pinned to their king
+u64 Board::getPinnedPieces(bool isWhite) {
+  return isWhite ? pinnedPieces<WHITE>() : pinnedPieces<BLACK>();
+}
+
+// Computes the check information stored with the current state
+void Board::updateCheckInfo() {
+  if (whiteToMove)
+    updateCheckInfo<WHITE>();
+  else
+    updateCheckInfo<BLACK>();
+}
 
-    u64 rayToKing = validMoveBB::bishopMoves(attacker, 0ULL, kingLoc);
-    u64 rayFromKing = validMoveBB::bishopMoves(kingLoc, 0ULL, attacker);
-    u64 betweenSquares = rayToKing & rayFromKing;
+template <Color Us> void Board::updateCheckInfo() {
+  constexpr Color Them = ~Us;
 
-    u64 piecesInBetween = betweenSquares & ownPieces;
+  // A piece is a king blocker if it is the only piece between the king and an
+  // enemy slider; if it belongs to the king's side it is pinned
+  for (Color color : {WHITE, BLACK}) {
+    Color enemy = ~color;
+    st.blockersForKing[color] = 0ULL;
+    st.pinners[enemy] = 0ULL;
 
-    // If exactly one friendly piece is between the attacker and the king, it is
-    // pinned
-    if (Utils::popcount(piecesInBetween) == 1) {
-      pinned |= piecesInBetween;
+    u64 king = pieces[color][KING];
+    if (king == 0ULL)
+      continue;
+    Square kingSquare = Utils::bitboardToSquare(king);
+
+    u64 snipers =
+        (Magic::getRookAttacks(kingSquare, 0ULL) &
+         (pieces[enemy][ROOK] | pieces[enemy][QUEEN])) |
+        (Magic::getBishopAttacks(kingSquare, 0ULL) &
+         (pieces[enemy][BISHOP] | pieces[enemy][QUEEN]));
+    u64 occupied = allPieces ^ snipers;
+
+    while (snipers) {
+      Square sniperSquare = Utils::popLSB(snipers);
+      u64 blockers = Magic::betweenSquares(kingSquare, sniperSquare) & occupied;
+      if (Utils::isOneBit(blockers)) {
+        st.blockersForKing[color] |= blockers;
+        if (blockers & occupancy[color])
+          st.pinners[enemy] |= Utils::squareToBitboard(sniperSquare);
+      }
     }
   }
 
-  // Check for pins from orthogonal sliders (rooks and queens)
-  u64 enemyOrthogonalSliders = isWhite ? (getBlackRooks() | getBlackQueens())
-                                       : (getWhiteRooks() | getWhiteQueens());
-
-  while (enemyOrthogonalSliders) {
-    Square attackerSq = Utils::popLSB(enemyOrthogonalSliders);
-    u64 attacker = Utils::squareToBitboard(attackerSq);
-
-    u64 fullRay = validMoveBB::rookMoves(attacker, 0ULL, 0ULL);
-    if ((fullRay & kingLoc) == 0)
-      continue;
+  // Enemy pieces attacking the king of the side to move
+  st.checkers = 0ULL;
+  u64 ourKing = pieces[Us][KING];
+  if (ourKing) {
+    Square kingSquare = Utils::bitboardToSquare(ourKing);
+    st.checkers = attackersTo(kingSquare, allPieces) & occupancy[Them];
+  }
 
-    u64 rayToKing = validMoveBB::rookMoves(attacker, 0ULL, kingLoc);
-    u64 rayFromKing = validMoveBB::rookMoves(kingLoc, 0ULL, attacker);
-    u64 betweenSquares = rayToKing & rayFromKing;
+  updateCheckSquares<Us>();
+}
 
-    u64 piecesInBetween = betweenSquares & ownPieces;
+// Computes the squares from which each of our piece kinds would attack the
+// enemy king
+void Board::updateCheckSquares() {
+  if (whiteToMove)
+    updateCheckSquares<WHITE>();
+  else
+    updateCheckSquares<BLACK>();
+}
 
-    if (Utils::popcount(piecesInBetween) == 1) {
-      pinned |= piecesInBetween;
-    }
+template <Color Us> void Board::updateCheckSquares() {
+  std::fill(std::begin(st.checkSquares), std::end(st.checkSquares), 0ULL);
+  u64 theirKing = pieces[~Us][KING];
+  if (theirKing) {
+    Square kingSquare = Utils::bitboardToSquare(theirKing);
+    st.checkSquares[PAWN] = Tables::PawnAttacks[~Us][kingSquare];
+    st.checkSquares[KNIGHT] = Tables::KnightAttacks[kingSquare];
+    st.checkSquares[BISHOP] = Magic::getBishopAttacks(kingSquare, allPieces);
+    st.checkSquares[ROOK] = Magic::getRookAttacks(kingSquare, allPieces);
+    st.checkSquares[QUEEN] = st.checkSquares[BISHOP] | st.checkSquares[ROOK];
   }
-
-  return pinned;
 }
 
 // Initializes the Zobrist hash for the current board state
 void Board::initZobristHash() {
-  zobristHash = 0ULL;
-
-  for (int sq = 0; sq < 64; sq++) {
-    PieceType piece = Utils::getPieceTypeAt(*this, static_cast<Square>(sq));
-    if (piece != EMPTY) {
-      zobristHash ^= zobrist.getPieceKey(sq, piece);
-    }
+  u64 zobristHash = 0ULL;
+  u64 pawnKey = 0ULL;
+  u64 materialKey = 0ULL;
+
+  int pieceCounts[13] = {};
+
+  u64 occupied = allPieces;
+  while (occupied) {
+    Square sq = Utils::popLSB(occupied);
+    PieceType piece = board[sq];
+    zobristHash ^= zobrist.getPieceKey(sq, piece);
+    materialKey ^= zobrist.getMaterialKey(piece, pieceCounts[piece]++);
+    if (piece == WHITE_PAWN || piece == BLACK_PAWN)
+      pawnKey ^= zobrist.getPieceKey(sq, piece);
   }
 
-  int castling = (canWhiteCastleKS ? 1 : 0) | (canWhiteCastleQS ? 2 : 0) |
-                 (canBlackCastleKS ? 4 : 0) | (canBlackCastleQS ? 8 : 0);
-  zobristHash ^= zobrist.getCastleKey(castling);
+  zobristHash ^= zobrist.getCastleKey(st.castlingRights);
 
-  if (enPassantSquare != SQ_NONE) {
-    zobristHash ^= zobrist.getEnPassantKey(enPassantSquare);
+  if (st.enPassantSquare != SQ_NONE) {
+    zobristHash ^= zobrist.getEnPassantKey(st.enPassantSquare);
   }
 
   if (!whiteToMove) {
     zobristHash ^= zobrist.getBlackToMoveKey();
   }
+
+  st.zobristHash = zobristHash;
+  st.pawnKey = pawnKey;
+  st.materialKey = materialKey;
 }
@@ -24,7 +24,7 @@ int Evaluation::getPieceSquareScore(Board &board) {
   int totalBonus = 0;
 
   for (int square = 0; square < 64; square++) {
-    PieceType piece = Utils::getPieceTypeAt(board, static_cast<Square>(square));
+    PieceType piece = board.pieceOn(static_cast<Square>(square));
 
     if (piece == EMPTY)
       continue; // Skip empty squares
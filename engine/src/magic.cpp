@@ -2,16 +2,16 @@
  * @file magic.cpp
  * @brief Implements magic bitboard move generation.
  * This file contains the implementation of magic bitboards for efficient
- * generation of sliding piece attacks (rooks and bishops).
+ * generation of sliding piece attacks (rooks and bishops). The attack tables
+ * are built at compile time and stored in read-only memory.
  */
 #include "../include/magic.hpp"
-#include "../include/utils.hpp"
 
 namespace Magic {
 
 // Pre-computed magic numbers for generating perfect hash functions for rook and
 // bishop attacks
-const u64 rookMagics[64] = {
+constexpr u64 rookMagics[64] = {
     0x8a80104000800020ULL, 0x140002000100040ULL,  0x2801880a0017001ULL,
     0x100081001000420ULL,  0x200020010080420ULL,  0x3001c0002010008ULL,
     0x8480008002000100ULL, 0x2080088004402900ULL, 0x800098204000ULL,
@@ -35,7 +35,7 @@ const u64 rookMagics[64] = {
     0x20030a0244872ULL,    0x12001008414402ULL,   0x2006104900a0804ULL,
     0x1004081002402ULL};
 
-const u64 bishopMagics[64] = {
+constexpr u64 bishopMagics[64] = {
     0x40040844404084ULL,   0x2004208a004208ULL,   0x10190041080202ULL,
     0x108060845042010ULL,  0x581104180800210ULL,  0x2112080446200010ULL,
     0x1080820820060210ULL, 0x3c0808410220200ULL,  0x4050404440404ULL,
@@ -55,30 +55,28 @@ const u64 bishopMagics[64] = {
     0x500861011240000ULL,  0x180806108200800ULL,  0x4000020e01040044ULL,
     0x300000261044000aULL, 0x802241102020002ULL,  0x20906061210001ULL,
     0x5a84841004010310ULL, 0x4010801011c04ULL,    0xa010109502200ULL,
-    0x4a02012000a03002ULL, 0x500201010098b028ULL, 0x8040002811040900ULL,
+    0x824004404210810ULL,  0x500201010098b028ULL, 0x8040002811040900ULL,
     0x28000010020204ULL,   0x6000020202d0240ULL,  0x8918844842082200ULL,
     0x4010011029020020ULL};
 
 // Number of relevant bits in the occupancy mask for each square
-const int rookBits[64] = {12, 11, 11, 11, 11, 11, 11, 12, 11, 10, 10, 10, 10,
+constexpr int rookBits[64] = {12, 11, 11, 11, 11, 11, 11, 12, 11, 10, 10, 10, 10,
                           10, 10, 11, 11, 10, 10, 10, 10, 10, 10, 11, 11, 10,
                           10, 10, 10, 10, 10, 11, 11, 10, 10, 10, 10, 10, 10,
                           11, 11, 10, 10, 10, 10, 10, 10, 11, 11, 10, 10, 10,
                           10, 10, 10, 11, 12, 11, 11, 11, 11, 11, 11, 12};
 
-const int bishopBits[64] = {6, 5, 5, 5, 5, 5, 5, 6, 5, 5, 5, 5, 5, 5, 5, 5,
+constexpr int bishopBits[64] = {6, 5, 5, 5, 5, 5, 5, 6, 5, 5, 5, 5, 5, 5, 5, 5,
                             5, 5, 7, 7, 7, 7, 5, 5, 5, 5, 7, 9, 9, 7, 5, 5,
                             5, 5, 7, 9, 9, 7, 5, 5, 5, 5, 7, 7, 7, 7, 5, 5,
                             5, 5, 5, 5, 5, 5, 5, 5, 6, 5, 5, 5, 5, 5, 5, 6};
 
-// Occupancy masks and attack tables for rooks and bishops
-u64 rookMasks[64];
-u64 bishopMasks[64];
-u64 rookAttacks[64][4096];
-u64 bishopAttacks[64][512];
+// Total attack table entries: the sum of 2^bits over all squares
+constexpr int ROOK_TABLE_SIZE = 102400;
+constexpr int BISHOP_TABLE_SIZE = 5248;
 
 // Generates the occupancy mask for a rook on a given square
-u64 maskRookOccupancy(Square sq) {
+static constexpr u64 maskRookOccupancy(Square sq) {
   u64 mask = 0ULL;
   int rank = sq / 8;
   int file = sq % 8;
@@ -96,7 +94,7 @@ u64 maskRookOccupancy(Square sq) {
 }
 
 // Generates the occupancy mask for a bishop on a given square
-u64 maskBishopOccupancy(Square sq) {
+static constexpr u64 maskBishopOccupancy(Square sq) {
   u64 mask = 0ULL;
   int rank = sq / 8;
   int file = sq % 8;
@@ -113,108 +111,128 @@ u64 maskBishopOccupancy(Square sq) {
   return mask;
 }
 
-// Generates rook attacks on the fly for a given blocker configuration
-u64 rookAttacksOnTheFly(Square sq, u64 blockers) {
-  u64 attacks = 0ULL;
-  int rank = sq / 8;
-  int file = sq % 8;
-
-  for (int r = rank + 1; r <= 7; r++) {
-    attacks |= (1ULL << (r * 8 + file));
-    if (blockers & (1ULL << (r * 8 + file)))
-      break;
-  }
-  for (int r = rank - 1; r >= 0; r--) {
-    attacks |= (1ULL << (r * 8 + file));
-    if (blockers & (1ULL << (r * 8 + file)))
-      break;
-  }
-  for (int f = file + 1; f <= 7; f++) {
-    attacks |= (1ULL << (rank * 8 + f));
-    if (blockers & (1ULL << (rank * 8 + f)))
-      break;
-  }
-  for (int f = file - 1; f >= 0; f--) {
-    attacks |= (1ULL << (rank * 8 + f));
-    if (blockers & (1ULL << (rank * 8 + f)))
-      break;
+// Ray directions as (file, rank) steps. The first four increase the square
+// index, so their nearest blocker is the lowest set bit.
+constexpr int rayDirections[8][2] = {{0, 1},  {1, 0},  {1, 1},   {-1, 1},
+                                     {0, -1}, {-1, 0}, {-1, -1}, {1, -1}};
+
+// Squares from each square to the board edge in each direction
+struct Rays {
+  u64 ray[8][64];
+};
+
+static constexpr Rays buildRays() {
+  Rays rays{};
+  for (int dir = 0; dir < 8; dir++) {
+    for (int sq = 0; sq < 64; sq++) {
+      int file = sq % 8 + rayDirections[dir][0];
+      int rank = sq / 8 + rayDirections[dir][1];
+      for (; file >= 0 && file < 8 && rank >= 0 && rank < 8;
+           file += rayDirections[dir][0], rank += rayDirections[dir][1])
+        rays.ray[dir][sq] |= 1ULL << (rank * 8 + file);
+    }
   }
-
-  return attacks;
+  return rays;
 }
 
-// Generates bishop attacks on the fly for a given blocker configuration
-u64 bishopAttacksOnTheFly(Square sq, u64 blockers) {
-  u64 attacks = 0ULL;
-  int rank = sq / 8;
-  int file = sq % 8;
-
-  for (int r = rank + 1, f = file + 1; r <= 7 && f <= 7; r++, f++) {
-    attacks |= (1ULL << (r * 8 + f));
-    if (blockers & (1ULL << (r * 8 + f)))
-      break;
-  }
-  for (int r = rank + 1, f = file - 1; r <= 7 && f >= 0; r++, f--) {
-    attacks |= (1ULL << (r * 8 + f));
-    if (blockers & (1ULL << (r * 8 + f)))
-      break;
-  }
-  for (int r = rank - 1, f = file + 1; r >= 0 && f <= 7; r--, f++) {
-    attacks |= (1ULL << (r * 8 + f));
-    if (blockers & (1ULL << (r * 8 + f)))
-      break;
-  }
-  for (int r = rank - 1, f = file - 1; r >= 0 && f >= 0; r--, f--) {
-    attacks |= (1ULL << (r * 8 + f));
-    if (blockers & (1ULL << (r * 8 + f)))
-      break;
-  }
+static constexpr Rays rays = buildRays();
 
-  return attacks;
+// Squares attacked along one ray, up to and including the first blocker
+static constexpr u64 rayAttacks(int dir, Square sq, u64 blockers) {
+  u64 ray = rays.ray[dir][sq];
+  u64 hit = ray & blockers;
+  if (!hit)
+    return ray;
+  int first = dir < 4 ? __builtin_ctzll(hit) : 63 - __builtin_clzll(hit);
+  return ray ^ rays.ray[dir][first];
 }
 
-// Generates all possible blocker configurations for a given attack mask
-u64 setOccupancy(int index, int bitsInMask, u64 attackMask) {
-  u64 occupancy = 0ULL;
+// Generates rook attacks on the fly for a given blocker configuration
+static constexpr u64 rookAttacksOnTheFly(Square sq, u64 blockers) {
+  return rayAttacks(0, sq, blockers) | rayAttacks(1, sq, blockers) |
+         rayAttacks(4, sq, blockers) | rayAttacks(5, sq, blockers);
+}
 
-  for (int count = 0; count < bitsInMask; count++) {
-    int square = __builtin_ctzll(attackMask);
-    attackMask &= attackMask - 1;
+// Generates bishop attacks on the fly for a given blocker configuration
+static constexpr u64 bishopAttacksOnTheFly(Square sq, u64 blockers) {
+  return rayAttacks(2, sq, blockers) | rayAttacks(3, sq, blockers) |
+         rayAttacks(6, sq, blockers) | rayAttacks(7, sq, blockers);
+}
 
-    if (index & (1ULL << count)) {
-      occupancy |= (1ULL << square);
-    }
-  }
+// Steps through the subsets of a mask in increasing order (Carry-Rippler),
+// which is the order in which PEXT numbers them
+static constexpr u64 nextSubset(u64 subset, u64 mask) {
+  return (subset - mask) & mask;
+}
 
-  return occupancy;
+// Slot of an occupancy within its square's slice. Under PEXT the slot is the
+// subset's position in the enumeration order.
+static constexpr std::size_t slotOf(u64 magic, int bits, int index,
+                                    u64 occupancy) {
+#ifdef USE_PEXT
+  (void)magic;
+  (void)bits;
+  (void)occupancy;
+  return index;
+#else
+  (void)index;
+  return (occupancy * magic) >> (64 - bits);
+#endif
 }
 
-// Initializes the magic bitboard tables for rooks and bishops
-void initMagics() {
+// Attack slices of every square back to back, rook squares first
+struct AttackTable {
+  u64 entries[ROOK_TABLE_SIZE + BISHOP_TABLE_SIZE];
+};
+
+static constexpr AttackTable buildAttackTable() {
+  AttackTable table{};
+  u64 *slice = table.entries;
   for (int sq = 0; sq < 64; sq++) {
-    rookMasks[sq] = maskRookOccupancy((Square)sq);
-    int relevantBits = rookBits[sq];
-    int occupancyIndices = (1 << relevantBits);
-
-    for (int index = 0; index < occupancyIndices; index++) {
-      u64 occupancy = setOccupancy(index, relevantBits, rookMasks[sq]);
-      int magicIndex = (occupancy * rookMagics[sq]) >> (64 - relevantBits);
-      rookAttacks[sq][magicIndex] = rookAttacksOnTheFly((Square)sq, occupancy);
+    u64 mask = maskRookOccupancy((Square)sq);
+    u64 occupancy = 0ULL;
+    for (int index = 0; index < (1 << rookBits[sq]); index++) {
+      slice[slotOf(rookMagics[sq], rookBits[sq], index, occupancy)] =
+          rookAttacksOnTheFly((Square)sq, occupancy);
+      occupancy = nextSubset(occupancy, mask);
     }
+    slice += 1 << rookBits[sq];
   }
-
   for (int sq = 0; sq < 64; sq++) {
-    bishopMasks[sq] = maskBishopOccupancy((Square)sq);
-    int relevantBits = bishopBits[sq];
-    int occupancyIndices = (1 << relevantBits);
-
-    for (int index = 0; index < occupancyIndices; index++) {
-      u64 occupancy = setOccupancy(index, relevantBits, bishopMasks[sq]);
-      int magicIndex = (occupancy * bishopMagics[sq]) >> (64 - relevantBits);
-      bishopAttacks[sq][magicIndex] =
+    u64 mask = maskBishopOccupancy((Square)sq);
+    u64 occupancy = 0ULL;
+    for (int index = 0; index < (1 << bishopBits[sq]); index++) {
+      slice[slotOf(bishopMagics[sq], bishopBits[sq], index, occupancy)] =
           bishopAttacksOnTheFly((Square)sq, occupancy);
+      occupancy = nextSubset(occupancy, mask);
     }
+    slice += 1 << bishopBits[sq];
+  }
+  return table;
+}
+
+static constexpr AttackTable attackTable = buildAttackTable();
+
+// Lookup entries of one piece type, handing each square its slice of the
+// attack table starting at 'attacks'
+static constexpr std::array<SquareMagic, 64>
+buildEntries(const u64 *magics, const int *bits, u64 (*maskOccupancy)(Square),
+             const u64 *attacks) {
+  std::array<SquareMagic, 64> entries{};
+  for (int sq = 0; sq < 64; sq++) {
+    entries[sq].mask = maskOccupancy((Square)sq);
+    entries[sq].magic = magics[sq];
+    entries[sq].attacks = attacks;
+    entries[sq].shift = 64 - bits[sq];
+    attacks += 1 << bits[sq];
   }
+  return entries;
 }
 
+constexpr std::array<SquareMagic, 64> rookTable = buildEntries(
+    rookMagics, rookBits, maskRookOccupancy, attackTable.entries);
+constexpr std::array<SquareMagic, 64> bishopTable =
+    buildEntries(bishopMagics, bishopBits, maskBishopOccupancy,
+                 attackTable.entries + ROOK_TABLE_SIZE);
+
 } // namespace Magic
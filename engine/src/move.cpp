@@ -2,7 +2,7 @@
  * @file move.cpp
  * @brief Implements the Move class.
  * This file contains the implementation of the Move class, including methods
- * for comparing and printing moves.
+ * for printing moves.
  */
 #include "../include/move.hpp"
 #include <string>
@@ -53,15 +53,18 @@ std::ostream &operator<<(std::ostream &os, const Move &move) {
   };
 
   os << squareToString(move.getFromSquare()) << "->"
-     << squareToString(move.getToSquare()) << " ["
-     << pieceToString(move.getPieceType()) << "]";
+     << squareToString(move.getToSquare());
+
+  if (move.isCastling()) {
+    os << (move.getIsKingSideCastle() ? " (O-O)" : " (O-O-O)");
+  }
 
   if (move.getIsEnPassant()) {
     os << " (en passant)";
   }
 
   if (move.getIsCapture()) {
-    os << " captures [" << pieceToString(move.getCapturedPiece()) << "]";
+    os << " captures";
   }
 
   if (move.getIsPromotion()) {
@@ -70,31 +73,3 @@ std::ostream &operator<<(std::ostream &os, const Move &move) {
 
   return os;
 }
-
-// Overloads the == operator to compare two moves for equality
-bool Move::operator==(const Move &other) const {
-  return fromSquare == other.fromSquare && toSquare == other.toSquare &&
-         pieceType == other.pieceType && capturedPiece == other.capturedPiece &&
-         promotionPiece == other.promotionPiece &&
-         isCapture == other.isCapture && isEnPassant == other.isEnPassant &&
-         isKingSideCastle == other.isKingSideCastle &&
-         isQueenSideCastle == other.isQueenSideCastle &&
-         isPromotion == other.isPromotion;
-}
-
-// Overloads the = operator to assign one move to another
-Move &Move::operator=(const Move &other) {
-  if (this != &other) {
-    fromSquare = other.fromSquare;
-    toSquare = other.toSquare;
-    pieceType = other.pieceType;
-    capturedPiece = other.capturedPiece;
-    promotionPiece = other.promotionPiece;
-    isCapture = other.isCapture;
-    isEnPassant = other.isEnPassant;
-    isKingSideCastle = other.isKingSideCastle;
-    isQueenSideCastle = other.isQueenSideCastle;
-    isPromotion = other.isPromotion;
-  }
-  return *this;
-}
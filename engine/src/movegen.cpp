@@ -7,6 +7,10 @@
 #include "../include/movegen.hpp"
 #include "../include/magic.hpp"
 #include "../include/utils.hpp"
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HAVE_AVX2_KOGGE_STONE 1
+#endif
 
 // Generates a bitboard of pseudo-legal king moves
 u64 validMoveBB::kingMoves(u64 kingLoc, u64 ownPieces) {
@@ -30,10 +34,8 @@ u64 validMoveBB::kingMoves(u64 kingLoc, u64 ownPieces) {
 }
 
 // Generates a list of pseudo-legal king moves
-std::vector<Move> MoveGeneration::generateKingMoves(Board &board,
-                                                    bool isWhite) {
-
-  std::vector<Move> moves;
+void MoveGeneration::generateKingMoves(Board &board, bool isWhite,
+                                       MoveList &moves) {
 
   // relevant bitboards
   u64 ownPieces =
@@ -41,11 +43,12 @@ std::vector<Move> MoveGeneration::generateKingMoves(Board &board,
   u64 enemyPieces =
       isWhite ? board.getAllBlackPieces() : board.getAllWhitePieces();
   u64 kingLoc = isWhite ? board.getWhiteKing() : board.getBlackKing();
-  u64 kingValid = validMoveBB::kingMoves(kingLoc, ownPieces);
+  if (!kingLoc)
+    return;
 
   // Get king position
   Square kingSquare = Utils::bitboardToSquare(kingLoc);
-  PieceType kingPiece = isWhite ? WHITE_KING : BLACK_KING;
+  u64 kingValid = Tables::KingAttacks[kingSquare] & ~ownPieces;
 
   while (kingValid) {
     Square toSquare = Utils::popLSB(kingValid); // Get square and remove bit
@@ -54,18 +57,9 @@ std::vector<Move> MoveGeneration::generateKingMoves(Board &board,
     u64 toSquareBitboard = Utils::squareToBitboard(toSquare);
     bool isCapture = (enemyPieces & toSquareBitboard) != 0;
 
-    if (isCapture) {
-      // Find what piece we're capturing
-      PieceType capturedPiece = Utils::getPieceTypeAt(board, toSquare);
-      moves.emplace_back(kingSquare, toSquare, kingPiece, capturedPiece, false,
-                         false, false, false, EMPTY); // Capture move
-    } else {
-      moves.emplace_back(kingSquare, toSquare, kingPiece, EMPTY, false, false,
-                         false, false, EMPTY); // Normal move
-    }
+    moves.emplace_back(kingSquare, toSquare, isCapture ? CAPTURE : QUIET_MOVE);
     // todo: add castling logic(both king and queenside)
   }
-  return moves;
 }
 
 // Generates a bitboard of pseudo-legal knight moves
@@ -92,10 +86,8 @@ u64 validMoveBB::knightMoves(u64 knightLoc, u64 ownPieces) {
 }
 
 // Generates a list of pseudo-legal knight moves
-std::vector<Move> MoveGeneration::generateKnightMoves(Board &board,
-                                                      bool isWhite) {
-
-  std::vector<Move> moves;
+void MoveGeneration::generateKnightMoves(Board &board, bool isWhite,
+                                         MoveList &moves) {
 
   // relevant bitboards
   u64 ownPieces =
@@ -104,147 +96,151 @@ std::vector<Move> MoveGeneration::generateKnightMoves(Board &board,
       isWhite ? board.getAllBlackPieces() : board.getAllWhitePieces();
   u64 knightLoc = isWhite ? board.getWhiteKnights() : board.getBlackKnights();
 
-  PieceType knightPiece = isWhite ? WHITE_KNIGHT : BLACK_KNIGHT;
-
   while (knightLoc) {
     Square currKnightSquare = Utils::popLSB(knightLoc);
-    u64 currKnight = Utils::squareToBitboard(currKnightSquare);
-    u64 knightValid = validMoveBB::knightMoves(currKnight, ownPieces);
+    u64 knightValid = Tables::KnightAttacks[currKnightSquare] & ~ownPieces;
     while (knightValid) {
       Square toSquare = Utils::popLSB(knightValid);
       bool isCapture = (enemyPieces & Utils::squareToBitboard(toSquare)) != 0;
-      if (isCapture) {
-        // Find what piece we're capturing
-        PieceType capturedPiece = Utils::getPieceTypeAt(board, toSquare);
-        moves.emplace_back(currKnightSquare, toSquare, knightPiece,
-                           capturedPiece, false, false, false, false,
-                           EMPTY); // Capture move
-      } else {
-        moves.emplace_back(currKnightSquare, toSquare, knightPiece, EMPTY,
-                           false, false, false, false, EMPTY); // Normal move
-      }
+      moves.emplace_back(currKnightSquare, toSquare,
+                         isCapture ? CAPTURE : QUIET_MOVE);
     }
   }
-  return moves;
 }
 
 // Generates a bitboard of pseudo-legal white pawn moves
-u64 validMoveBB::whitePawnMoves(u64 whitePawns, u64 ownPieces, u64 allPieces,
-                                u64 enemyPieces) {
+u64 validMoveBB::whitePawnMoves(u64 whitePawns, u64 /*ownPieces*/,
+                                u64 allPieces, u64 enemyPieces) {
+  return pawnMoves<WHITE>(whitePawns, allPieces, enemyPieces);
+}
 
-  u64 one_square_forward = (whitePawns << 8) & ~allPieces;
-  u64 two_square_forward =
-      ((one_square_forward & Tables::maskRank[2]) << 8) & ~allPieces;
-  u64 validMoves = one_square_forward | two_square_forward;
+// Generates a bitboard of pseudo-legal black pawn moves
+u64 validMoveBB::blackPawnMoves(u64 blackPawns, u64 /*ownPieces*/,
+                                u64 allPieces, u64 enemyPieces) {
+  return pawnMoves<BLACK>(blackPawns, allPieces, enemyPieces);
+}
 
-  u64 white_pawn_attack_left = (whitePawns & Tables::clearFile[0]) << 7;
-  u64 white_pawn_attack_right = (whitePawns & Tables::clearFile[7]) << 9;
-  u64 allAttacks = white_pawn_attack_left | white_pawn_attack_right;
+namespace {
 
-  u64 validAttacks = allAttacks & enemyPieces;
+// Which part of the legal moves a generator call produces. Captures include
+// every promotion, so the two stages together cover all legal moves.
+enum GenType { GEN_ALL, GEN_CAPTURES, GEN_QUIETS };
 
-  return validMoves | validAttacks;
+// Shifts a bitboard by a signed number of squares
+template <int D> constexpr u64 shift(u64 bb) {
+  if constexpr (D > 0)
+    return bb << D;
+  else
+    return bb >> -D;
 }
 
-// Generates a bitboard of pseudo-legal black pawn moves
-u64 validMoveBB::blackPawnMoves(u64 blackPawns, u64 ownPieces, u64 allPieces,
-                                u64 enemyPieces) {
-
-  u64 one_square_forward = (blackPawns >> 8) & ~allPieces;
-  u64 two_square_forward =
-      ((one_square_forward & Tables::maskRank[5]) >> 8) & ~allPieces;
-  u64 validMoves = one_square_forward | two_square_forward;
+// Appends a move onto every square of 'targets' from the square 'offset'
+// behind it
+inline void addPawnTargets(u64 targets, int offset, MoveFlag flag,
+                           MoveList &moves) {
+  while (targets) {
+    Square to = Utils::popLSB(targets);
+    moves.emplace_back(static_cast<Square>(to - offset), to, flag);
+  }
+}
 
-  u64 black_pawn_attack_left = (blackPawns & Tables::clearFile[0]) >> 9;
-  u64 black_pawn_attack_right = (blackPawns & Tables::clearFile[7]) >> 7;
-  u64 allAttacks = black_pawn_attack_left | black_pawn_attack_right;
+inline void addPromotionTargets(u64 targets, int offset, bool isCapture,
+                                MoveList &moves) {
+  while (targets) {
+    Square to = Utils::popLSB(targets);
+    Square from = static_cast<Square>(to - offset);
+    for (PieceKind kind : {QUEEN, KNIGHT, BISHOP, ROOK})
+      moves.emplace_back(from, to, Move::promotionFlag(kind, isCapture));
+  }
+}
 
-  u64 validAttacks = allAttacks & enemyPieces;
+// Generates the pushes, double pushes, captures and promotions of a whole set
+// of pawns of color Us with one shift per direction. Destinations are limited
+// to 'targets'; en passant is left to the callers.
+template <Color Us>
+void addPawnMovesSetwise(u64 pawns, u64 allPieces, u64 enemyPieces,
+                         u64 targets, GenType type, MoveList &moves) {
+  constexpr int up = Us == WHITE ? 8 : -8;
+  constexpr int upLeft = Us == WHITE ? 7 : -9;
+  constexpr int upRight = Us == WHITE ? 9 : -7;
+  const u64 seventhRank = Tables::maskRank[Us == WHITE ? 6 : 1];
+  const u64 thirdRank = Tables::maskRank[Us == WHITE ? 2 : 5];
+  const u64 notFileA = Tables::clearFile[0];
+  const u64 notFileH = Tables::clearFile[7];
+
+  u64 empty = ~allPieces;
+  u64 promoting = pawns & seventhRank;
+  u64 others = pawns & ~seventhRank;
+
+  if (type != GEN_CAPTURES) {
+    u64 singlePush = shift<up>(others) & empty;
+    u64 doublePush = shift<up>(singlePush & thirdRank) & empty;
+    addPawnTargets(singlePush & targets, up, QUIET_MOVE, moves);
+    addPawnTargets(doublePush & targets, 2 * up, QUIET_MOVE, moves);
+  }
 
-  return validMoves | validAttacks;
+  // Promotions belong to the capture stage even when they do not capture
+  if (type != GEN_QUIETS) {
+    u64 enemies = enemyPieces & targets;
+    addPawnTargets(shift<upLeft>(others & notFileA) & enemies, upLeft, CAPTURE,
+                   moves);
+    addPawnTargets(shift<upRight>(others & notFileH) & enemies, upRight,
+                   CAPTURE, moves);
+
+    if (promoting) {
+      addPromotionTargets(shift<up>(promoting) & empty & targets, up, false,
+                          moves);
+      addPromotionTargets(shift<upLeft>(promoting & notFileA) & enemies,
+                          upLeft, true, moves);
+      addPromotionTargets(shift<upRight>(promoting & notFileH) & enemies,
+                          upRight, true, moves);
+    }
+  }
 }
 
-// Generates a list of pseudo-legal pawn promotion moves
-std::vector<Move> MoveGeneration::generatePawnPromotionMoves(Board &board,
-                                                             u64 pawnLoc,
-                                                             bool isWhite) {
+// Resolves the side once and runs the setwise pawn generator for it
+inline void addPawnMovesSetwise(bool isWhite, u64 pawns, u64 allPieces,
+                                u64 enemyPieces, u64 targets, GenType type,
+                                MoveList &moves) {
+  if (isWhite)
+    addPawnMovesSetwise<WHITE>(pawns, allPieces, enemyPieces, targets, type,
+                               moves);
+  else
+    addPawnMovesSetwise<BLACK>(pawns, allPieces, enemyPieces, targets, type,
+                               moves);
+}
 
-  std::vector<Move> promotionMoves;
+} // namespace
 
-  u64 ownPieces =
-      isWhite ? board.getAllWhitePieces() : board.getAllBlackPieces();
+// Generates a list of pseudo-legal pawn promotion moves
+void MoveGeneration::generatePawnPromotionMoves(Board &board, u64 pawnLoc,
+                                                bool isWhite, MoveList &moves) {
   u64 enemyPieces =
       isWhite ? board.getAllBlackPieces() : board.getAllWhitePieces();
-  u64 allPieces = board.getAllPieces();
-
-  PieceType pawnPiece = isWhite ? WHITE_PAWN : BLACK_PAWN;
-
-  while (pawnLoc) {
-    Square currPawnSquare = Utils::popLSB(pawnLoc);
-    u64 currPawn = Utils::squareToBitboard(currPawnSquare);
-    u64 pawnValid = isWhite
-                        ? validMoveBB::whitePawnMoves(currPawn, ownPieces,
-                                                      allPieces, enemyPieces)
-                        : validMoveBB::blackPawnMoves(currPawn, ownPieces,
-                                                      allPieces, enemyPieces);
-    while (pawnValid) {
-      Square toSquare = Utils::popLSB(pawnValid);
-      bool isCapture = (enemyPieces & Utils::squareToBitboard(toSquare)) != 0;
-      if (isCapture) {
-        // Find what piece we're capturing
-        PieceType capturedPiece = Utils::getPieceTypeAt(board, toSquare);
-        promotionMoves.emplace_back(currPawnSquare, toSquare, pawnPiece,
-                                    capturedPiece, false, false, false, true,
-                                    isWhite ? WHITE_QUEEN : BLACK_QUEEN);
-        promotionMoves.emplace_back(
-            currPawnSquare, toSquare, pawnPiece, capturedPiece, false, false,
-            false, true, isWhite ? WHITE_KNIGHT : BLACK_KNIGHT); // Capture move
-        promotionMoves.emplace_back(currPawnSquare, toSquare, pawnPiece,
-                                    capturedPiece, false, false, false, true,
-                                    isWhite ? WHITE_BISHOP : BLACK_BISHOP);
-        promotionMoves.emplace_back(currPawnSquare, toSquare, pawnPiece,
-                                    capturedPiece, false, false, false, true,
-                                    isWhite ? WHITE_ROOK : BLACK_ROOK);
-      } else {
-        promotionMoves.emplace_back(currPawnSquare, toSquare, pawnPiece, EMPTY,
-                                    false, false, false, true,
-                                    isWhite ? WHITE_QUEEN : BLACK_QUEEN);
-        promotionMoves.emplace_back(
-            currPawnSquare, toSquare, pawnPiece, EMPTY, false, false, false,
-            true, isWhite ? WHITE_KNIGHT : BLACK_KNIGHT); // Normal move
-        promotionMoves.emplace_back(currPawnSquare, toSquare, pawnPiece, EMPTY,
-                                    false, false, false, true,
-                                    isWhite ? WHITE_BISHOP : BLACK_BISHOP);
-        promotionMoves.emplace_back(currPawnSquare, toSquare, pawnPiece, EMPTY,
-                                    false, false, false, true,
-                                    isWhite ? WHITE_ROOK : BLACK_ROOK);
-      }
-    }
-  }
-  return promotionMoves;
+  u64 promoPawns =
+      pawnLoc & (isWhite ? Tables::maskRank[6] : Tables::maskRank[1]);
+  addPawnMovesSetwise(isWhite, promoPawns, board.getAllPieces(), enemyPieces,
+                      ~0ULL, GEN_CAPTURES, moves);
 }
 
 // Generates a list of pseudo-legal en passant moves
-std::vector<Move> MoveGeneration::generateEnPassantMoves(Board &board,
-                                                         bool isWhite) {
-  std::vector<Move> enPassantMoves;
+void MoveGeneration::generateEnPassantMoves(Board &board, bool isWhite,
+                                            MoveList &moves) {
 
   // Get en passant target from FEN
   Square enPassantTarget = board.getEnPassantSquare();
   if (enPassantTarget == SQ_NONE) {
-    return {};
+    return;
   }
 
   u64 pawns = isWhite ? board.getWhitePawns() : board.getBlackPawns();
-  PieceType pawnPiece = isWhite ? WHITE_PAWN : BLACK_PAWN;
-  PieceType capturedPiece = isWhite ? BLACK_PAWN : WHITE_PAWN;
 
   // Get pawns on the correct rank for en passant (rank 5 for white, rank 4 for
   // black)
   u64 enPassantPawns =
       isWhite ? pawns & Tables::maskRank[4] : pawns & Tables::maskRank[3];
   if (enPassantPawns == 0) {
-    return {};
+    return;
   }
 
   int targetFile = enPassantTarget % 8;
@@ -263,140 +259,38 @@ std::vector<Move> MoveGeneration::generateEnPassantMoves(Board &board,
         isWhite ? (pawnRank + 1 == targetRank) : (pawnRank - 1 == targetRank);
 
     if ((canCaptureLeft || canCaptureRight) && correctRankRelation) {
-      enPassantMoves.emplace_back(currPawnSquare, enPassantTarget, pawnPiece,
-                                  capturedPiece, true, false, false, false,
-                                  EMPTY);
+      moves.emplace_back(currPawnSquare, enPassantTarget, EN_PASSANT);
     }
   }
-
-  return enPassantMoves;
 }
 
 // Generates a list of pseudo-legal pawn moves
-std::vector<Move> MoveGeneration::generatePawnMoves(Board &board,
-                                                    bool isWhite) {
+void MoveGeneration::generatePawnMoves(Board &board, bool isWhite,
+                                       MoveList &moves) {
 
-  std::vector<Move> moves;
-  std::vector<Move> enPassantMoves = generateEnPassantMoves(board, isWhite);
-  moves.insert(moves.end(), enPassantMoves.begin(), enPassantMoves.end());
+  generateEnPassantMoves(board, isWhite, moves);
 
-  // relevant bitboards
-  u64 ownPieces =
-      isWhite ? board.getAllWhitePieces() : board.getAllBlackPieces();
+  u64 pawns = isWhite ? board.getWhitePawns() : board.getBlackPawns();
   u64 enemyPieces =
       isWhite ? board.getAllBlackPieces() : board.getAllWhitePieces();
-
-  u64 pawns = isWhite ? board.getWhitePawns() : board.getBlackPawns();
-  u64 promoPawns =
-      isWhite ? pawns & Tables::maskRank[6] : pawns & Tables::maskRank[1];
-
-  if (promoPawns != 0) {
-    std::vector<Move> promotionMoves =
-        generatePawnPromotionMoves(board, promoPawns, isWhite);
-    moves.insert(moves.end(), promotionMoves.begin(), promotionMoves.end());
-  }
-
-  u64 pawnLoc = pawns & ~promoPawns;
-
-  u64 allPieces = board.getAllPieces();
-
-  PieceType pawnPiece = isWhite ? WHITE_PAWN : BLACK_PAWN;
-
-  while (pawnLoc) {
-    Square currPawnSquare = Utils::popLSB(pawnLoc);
-    u64 currPawn = Utils::squareToBitboard(currPawnSquare);
-    u64 pawnValid = isWhite
-                        ? validMoveBB::whitePawnMoves(currPawn, ownPieces,
-                                                      allPieces, enemyPieces)
-                        : validMoveBB::blackPawnMoves(currPawn, ownPieces,
-                                                      allPieces, enemyPieces);
-    while (pawnValid) {
-      Square toSquare = Utils::popLSB(pawnValid);
-      bool isCapture = (enemyPieces & Utils::squareToBitboard(toSquare)) != 0;
-      if (isCapture) {
-        // Find what piece we're capturing
-        PieceType capturedPiece = Utils::getPieceTypeAt(board, toSquare);
-        moves.emplace_back(currPawnSquare, toSquare, pawnPiece, capturedPiece,
-                           false, false, false, false, EMPTY); // Capture move
-      } else {
-        moves.emplace_back(currPawnSquare, toSquare, pawnPiece, EMPTY, false,
-                           false, false, false, EMPTY); // Normal move
-      }
-    }
-  }
-  return moves;
+  addPawnMovesSetwise(isWhite, pawns, board.getAllPieces(), enemyPieces,
+                      ~0ULL, GEN_ALL, moves);
 }
 
 // Generates a bitboard of white pawn attacks
 u64 validMoveBB::whitePawnAttacks(u64 pawnLoc) {
-  u64 attacks = 0ULL;
-  attacks |= (pawnLoc & Tables::clearFile[0]) << 7;
-  // Right attacks (northeast)
-  attacks |= (pawnLoc & Tables::clearFile[7]) << 9;
-  return attacks;
+  return pawnAttacks<WHITE>(pawnLoc);
 }
 
 // Generates a bitboard of black pawn attacks
 u64 validMoveBB::blackPawnAttacks(u64 pawnLoc) {
-  u64 attacks = 0ULL;
-  // Left attacks (southwest)
-  attacks |= (pawnLoc & Tables::clearFile[0]) >> 9;
-  // Right attacks (southeast)
-  attacks |= (pawnLoc & Tables::clearFile[7]) >> 7;
-  return attacks;
+  return pawnAttacks<BLACK>(pawnLoc);
 }
 
 // Generates a bitboard of all squares attacked by the enemy
 u64 validMoveBB::allEnemyAttacks(Board &board, bool isWhite) {
-  u64 enemyAttacks = 0ULL;
-  u64 ownPieces =
-      isWhite ? board.getAllBlackPieces() : board.getAllWhitePieces();
-  u64 enemyPieces =
-      isWhite ? board.getAllWhitePieces() : board.getAllBlackPieces();
-  u64 allPieces = ownPieces | enemyPieces; // Total occupancy
-
-  u64 enemyPawns = isWhite ? board.getWhitePawns() : board.getBlackPawns();
-  u64 enemyKnights =
-      isWhite ? board.getWhiteKnights() : board.getBlackKnights();
-  u64 enemyBishops =
-      isWhite ? board.getWhiteBishops() : board.getBlackBishops();
-  u64 enemyRooks = isWhite ? board.getWhiteRooks() : board.getBlackRooks();
-  u64 enemyQueens = isWhite ? board.getWhiteQueens() : board.getBlackQueens();
-  u64 enemyKing = isWhite ? board.getWhiteKing() : board.getBlackKing();
-
-  // Pawns
-  enemyAttacks |= isWhite ? validMoveBB::whitePawnAttacks(enemyPawns)
-                          : validMoveBB::blackPawnAttacks(enemyPawns);
-
-  // Knights
-  enemyAttacks |= validMoveBB::knightMoves(enemyKnights, enemyPieces);
-
-  // Bishops
-  u64 bishops = enemyBishops;
-  while (bishops) {
-    Square bishopSq = Utils::popLSB(bishops);
-    enemyAttacks |= Magic::getBishopAttacks(bishopSq, allPieces);
-  }
-
-  // Rooks
-  u64 rooks = enemyRooks;
-  while (rooks) {
-    Square rookSq = Utils::popLSB(rooks);
-    enemyAttacks |= Magic::getRookAttacks(rookSq, allPieces);
-  }
-
-  // Queens
-  u64 queens = enemyQueens;
-  while (queens) {
-    Square queenSq = Utils::popLSB(queens);
-    enemyAttacks |= Magic::getBishopAttacks(queenSq, allPieces);
-    enemyAttacks |= Magic::getRookAttacks(queenSq, allPieces);
-  }
-
-  // King
-  enemyAttacks |= validMoveBB::kingMoves(enemyKing, enemyPieces);
-
-  return enemyAttacks;
+  return isWhite ? attacksBy<WHITE>(board, board.getAllPieces())
+                 : attacksBy<BLACK>(board, board.getAllPieces());
 }
 
 // Generates a bitboard of pseudo-legal rook moves
@@ -412,10 +306,8 @@ u64 validMoveBB::rookMoves(u64 rookLoc, u64 ownPieces, u64 enemyPieces) {
 }
 
 // Generates a list of pseudo-legal rook moves
-std::vector<Move> MoveGeneration::generateRookMoves(Board &board,
-                                                    bool isWhite) {
-
-  std::vector<Move> moves;
+void MoveGeneration::generateRookMoves(Board &board, bool isWhite,
+                                       MoveList &moves) {
 
   // relevant bitboards
   u64 ownPieces =
@@ -424,8 +316,6 @@ std::vector<Move> MoveGeneration::generateRookMoves(Board &board,
       isWhite ? board.getAllBlackPieces() : board.getAllWhitePieces();
   u64 rookLoc = isWhite ? board.getWhiteRooks() : board.getBlackRooks();
 
-  PieceType rookPiece = isWhite ? WHITE_ROOK : BLACK_ROOK;
-
   while (rookLoc) {
     Square currRookSquare = Utils::popLSB(rookLoc);
     u64 currRook = Utils::squareToBitboard(currRookSquare);
@@ -433,18 +323,10 @@ std::vector<Move> MoveGeneration::generateRookMoves(Board &board,
     while (rookValid) {
       Square toSquare = Utils::popLSB(rookValid);
       bool isCapture = (enemyPieces & Utils::squareToBitboard(toSquare)) != 0;
-      if (isCapture) {
-        // Find what piece we're capturing
-        PieceType capturedPiece = Utils::getPieceTypeAt(board, toSquare);
-        moves.emplace_back(currRookSquare, toSquare, rookPiece, capturedPiece,
-                           false, false, false, false, EMPTY); // Capture move
-      } else {
-        moves.emplace_back(currRookSquare, toSquare, rookPiece, EMPTY, false,
-                           false, false, false, EMPTY); // Normal move
-      }
+      moves.emplace_back(currRookSquare, toSquare,
+                         isCapture ? CAPTURE : QUIET_MOVE);
     }
   }
-  return moves;
 }
 
 // Generates a bitboard of pseudo-legal bishop moves
@@ -460,9 +342,8 @@ u64 validMoveBB::bishopMoves(u64 bishopLoc, u64 ownPieces, u64 enemyPieces) {
 }
 
 // Generates a list of pseudo-legal bishop moves
-std::vector<Move> MoveGeneration::generateBishopMoves(Board &board,
-                                                      bool isWhite) {
-  std::vector<Move> moves;
+void MoveGeneration::generateBishopMoves(Board &board, bool isWhite,
+                                         MoveList &moves) {
 
   // relevant bitboards
   u64 ownPieces =
@@ -471,8 +352,6 @@ std::vector<Move> MoveGeneration::generateBishopMoves(Board &board,
       isWhite ? board.getAllBlackPieces() : board.getAllWhitePieces();
   u64 bishopLoc = isWhite ? board.getWhiteBishops() : board.getBlackBishops();
 
-  PieceType bishopPiece = isWhite ? WHITE_BISHOP : BLACK_BISHOP;
-
   while (bishopLoc) {
     Square currBishopSquare = Utils::popLSB(bishopLoc);
     u64 currBishop = Utils::squareToBitboard(currBishopSquare);
@@ -481,19 +360,10 @@ std::vector<Move> MoveGeneration::generateBishopMoves(Board &board,
     while (bishopValid) {
       Square toSquare = Utils::popLSB(bishopValid);
       bool isCapture = (enemyPieces & Utils::squareToBitboard(toSquare)) != 0;
-      if (isCapture) {
-        // Find what piece we're capturing
-        PieceType capturedPiece = Utils::getPieceTypeAt(board, toSquare);
-        moves.emplace_back(currBishopSquare, toSquare, bishopPiece,
-                           capturedPiece, false, false, false, false,
-                           EMPTY); // Capture move
-      } else {
-        moves.emplace_back(currBishopSquare, toSquare, bishopPiece, EMPTY,
-                           false, false, false, false, EMPTY); // Normal move
-      }
+      moves.emplace_back(currBishopSquare, toSquare,
+                         isCapture ? CAPTURE : QUIET_MOVE);
     }
   }
-  return moves;
 }
 
 // Generates a bitboard of pseudo-legal queen moves
@@ -503,9 +373,8 @@ u64 validMoveBB::queenMoves(u64 queenLoc, u64 ownPieces, u64 enemyPieces) {
 }
 
 // Generates a list of pseudo-legal queen moves
-std::vector<Move> MoveGeneration::generateQueenMoves(Board &board,
-                                                     bool isWhite) {
-  std::vector<Move> moves;
+void MoveGeneration::generateQueenMoves(Board &board, bool isWhite,
+                                        MoveList &moves) {
 
   // relevant bitboards
   u64 ownPieces =
@@ -514,8 +383,6 @@ std::vector<Move> MoveGeneration::generateQueenMoves(Board &board,
       isWhite ? board.getAllBlackPieces() : board.getAllWhitePieces();
   u64 queenLoc = isWhite ? board.getWhiteQueens() : board.getBlackQueens();
 
-  PieceType queenPiece = isWhite ? WHITE_QUEEN : BLACK_QUEEN;
-
   while (queenLoc) {
     Square currQueenSquare = Utils::popLSB(queenLoc);
     u64 currQueen = Utils::squareToBitboard(currQueenSquare);
@@ -523,19 +390,10 @@ std::vector<Move> MoveGeneration::generateQueenMoves(Board &board,
     while (queenValid) {
       Square toSquare = Utils::popLSB(queenValid);
       bool isCapture = (enemyPieces & Utils::squareToBitboard(toSquare)) != 0;
-      if (isCapture) {
-        // Find what piece we're capturing
-        PieceType capturedPiece = Utils::getPieceTypeAt(board, toSquare);
-        moves.emplace_back(currQueenSquare, toSquare, queenPiece, capturedPiece,
-                           false, false, false, false,
-                           EMPTY); // Capture move
-      } else {
-        moves.emplace_back(currQueenSquare, toSquare, queenPiece, EMPTY, false,
-                           false, false, false, EMPTY); // Normal move
-      }
+      moves.emplace_back(currQueenSquare, toSquare,
+                         isCapture ? CAPTURE : QUIET_MOVE);
     }
   }
-  return moves;
 }
 
 // Generates a bitboard of legal king moves
@@ -545,328 +403,591 @@ u64 validMoveBB::kingLegalMoves(Board &board, bool isWhite) {
   u64 ownPieces =
       isWhite ? board.getAllWhitePieces() : board.getAllBlackPieces();
   u64 kingLoc = isWhite ? board.getWhiteKing() : board.getBlackKing();
-  u64 pseudoLegalMoves = validMoveBB::kingMoves(kingLoc, ownPieces);
+  if (!kingLoc)
+    return 0ULL;
+  u64 pseudoLegalMoves =
+      Tables::KingAttacks[Utils::bitboardToSquare(kingLoc)] & ~ownPieces;
   u64 enemyAttacks = allEnemyAttacks(board, !isWhite);
 
   u64 legalMoves = pseudoLegalMoves & ~enemyAttacks;
   return legalMoves;
 }
 
-// Generates a list of legal king moves
-std::vector<Move> MoveGeneration::generateKingLegalMoves(Board &board,
-                                                         bool isWhite) {
-
-  std::vector<Move> legalKingMoves;
-
-  std::vector<Move> castlingMoves = generateCastlingMoves(board, isWhite);
-  legalKingMoves.insert(legalKingMoves.end(), castlingMoves.begin(),
-                        castlingMoves.end());
-
-  std::vector<Move> pseudoLegalKingMoves = generateKingMoves(board, isWhite);
-  for (const Move &move : pseudoLegalKingMoves) {
-    board.makeMove(move);
-    if (!board.isKingChecked(isWhite)) {
-      legalKingMoves.push_back(move);
-    }
-    board.undoMove();
-  }
-  return legalKingMoves;
+// Slider attacks one piece at a time through the magic tables
+u64 validMoveBB::sliderAttacksScalar(u64 diagonal, u64 straight,
+                                     u64 occupied) {
+  u64 attacks = 0ULL;
+  while (diagonal)
+    attacks |= Magic::getBishopAttacks(Utils::popLSB(diagonal), occupied);
+  while (straight)
+    attacks |= Magic::getRookAttacks(Utils::popLSB(straight), occupied);
+  return attacks;
 }
 
-// Generates a list of legal pawn moves
-std::vector<Move> MoveGeneration::generatePawnLegalMoves(Board &board,
-                                                         bool isWhite,
-                                                         bool inCheck,
-                                                         u64 pinnedPieces) {
-  std::vector<Move> pseudoLegal = generatePawnMoves(board, isWhite);
+#ifdef HAVE_AVX2_KOGGE_STONE
+// Kogge-Stone occluded fill of every slider at once. Each 256-bit vector holds
+// four directions, one per 64-bit lane: north, east, north-east and north-west
+// shift left, and their opposites shift right by the same amounts. A lane's
+// wrap mask keeps the fill from crossing the A/H file edge.
+__attribute__((target("avx2"))) u64
+validMoveBB::sliderAttacksAvx2(u64 diagonal, u64 straight, u64 occupied) {
+  const u64 notA = Tables::clearFile[0];
+  const u64 notH = Tables::clearFile[7];
+  const __m256i shift1 = _mm256_setr_epi64x(8, 1, 9, 7);
+  const __m256i shift2 = _mm256_setr_epi64x(16, 2, 18, 14);
+  const __m256i shift4 = _mm256_setr_epi64x(32, 4, 36, 28);
+  const __m256i empty = _mm256_set1_epi64x(~occupied);
+
+  // Left shifts: N, E, NE, NW
+  __m256i wrap = _mm256_setr_epi64x(~0ULL, notA, notA, notH);
+  __m256i gen = _mm256_setr_epi64x(straight, straight, diagonal, diagonal);
+  __m256i pro = _mm256_and_si256(empty, wrap);
+  gen = _mm256_or_si256(gen,
+                        _mm256_and_si256(pro, _mm256_sllv_epi64(gen, shift1)));
+  pro = _mm256_and_si256(pro, _mm256_sllv_epi64(pro, shift1));
+  gen = _mm256_or_si256(gen,
+                        _mm256_and_si256(pro, _mm256_sllv_epi64(gen, shift2)));
+  pro = _mm256_and_si256(pro, _mm256_sllv_epi64(pro, shift2));
+  gen = _mm256_or_si256(gen,
+                        _mm256_and_si256(pro, _mm256_sllv_epi64(gen, shift4)));
+  __m256i attacks = _mm256_and_si256(wrap, _mm256_sllv_epi64(gen, shift1));
+
+  // Right shifts: S, W, SW, SE
+  wrap = _mm256_setr_epi64x(~0ULL, notH, notH, notA);
+  gen = _mm256_setr_epi64x(straight, straight, diagonal, diagonal);
+  pro = _mm256_and_si256(empty, wrap);
+  gen = _mm256_or_si256(gen,
+                        _mm256_and_si256(pro, _mm256_srlv_epi64(gen, shift1)));
+  pro = _mm256_and_si256(pro, _mm256_srlv_epi64(pro, shift1));
+  gen = _mm256_or_si256(gen,
+                        _mm256_and_si256(pro, _mm256_srlv_epi64(gen, shift2)));
+  pro = _mm256_and_si256(pro, _mm256_srlv_epi64(pro, shift2));
+  gen = _mm256_or_si256(gen,
+                        _mm256_and_si256(pro, _mm256_srlv_epi64(gen, shift4)));
+  attacks = _mm256_or_si256(
+      attacks, _mm256_and_si256(wrap, _mm256_srlv_epi64(gen, shift1)));
+
+  // Fold the four lanes together
+  __m128i folded = _mm_or_si128(_mm256_castsi256_si128(attacks),
+                                _mm256_extracti128_si256(attacks, 1));
+  return _mm_cvtsi128_si64(folded) | _mm_extract_epi64(folded, 1);
+}
 
-  std::vector<Move> legal;
-  legal.reserve(pseudoLegal.size());
+bool validMoveBB::hasAvx2SliderAttacks() {
+  // May run during static initialization, before the CPU model is set up
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx2");
+}
+#else
+u64 validMoveBB::sliderAttacksAvx2(u64 diagonal, u64 straight, u64 occupied) {
+  return sliderAttacksScalar(diagonal, straight, occupied);
+}
 
-  for (const Move &move : pseudoLegal) {
-    Square fromSq = move.getFromSquare();
-    u64 fromBB = Utils::squareToBitboard(fromSq);
+bool validMoveBB::hasAvx2SliderAttacks() { return false; }
+#endif
 
-    // Fast path: non-pinned, non-en-passant moves when not in check
-    if (!inCheck && (fromBB & pinnedPieces) == 0 && !move.getIsEnPassant()) {
-      legal.push_back(move);
-      continue;
-    }
+namespace {
 
-    board.makeMove(move);
-    if (!board.isKingChecked(isWhite)) {
-      legal.push_back(move);
-    }
-    board.undoMove();
-  }
+using SliderAttacksFn = u64 (*)(u64, u64, u64);
 
-  return legal;
+// Picks the AVX2 fill when the CPU has it, the magic lookups otherwise
+SliderAttacksFn selectSliderAttacks() {
+  return validMoveBB::hasAvx2SliderAttacks() ? validMoveBB::sliderAttacksAvx2
+                                             : validMoveBB::sliderAttacksScalar;
 }
 
-// Generates a list of legal knight moves
-std::vector<Move> MoveGeneration::generateKnightLegalMoves(Board &board,
-                                                           bool isWhite,
-                                                           bool inCheck,
-                                                           u64 pinnedPieces) {
-  std::vector<Move> pseudoLegal = generateKnightMoves(board, isWhite);
+const SliderAttacksFn sliderAttacksImpl = selectSliderAttacks();
 
-  if (!inCheck && pinnedPieces == 0ULL) {
-    return pseudoLegal;
-  }
+} // namespace
 
-  std::vector<Move> legal;
-  legal.reserve(pseudoLegal.size());
+// Every square attacked by the given diagonal and straight sliders
+u64 validMoveBB::sliderAttacks(u64 diagonal, u64 straight, u64 occupied) {
+  return sliderAttacksImpl(diagonal, straight, occupied);
+}
 
-  for (const Move &move : pseudoLegal) {
-    Square fromSq = move.getFromSquare();
-    u64 fromBB = Utils::squareToBitboard(fromSq);
+// Every square attacked by color C under the given occupancy
+template <Color C>
+u64 validMoveBB::attacksBy(const Board &board, u64 occupied) {
+  u64 attacks = pawnAttacks<C>(board.getPieces(C, PAWN));
+  attacks |= knightMoves(board.getPieces(C, KNIGHT), 0ULL);
+  if (u64 king = board.getPieces(C, KING))
+    attacks |= Tables::KingAttacks[Utils::bitboardToSquare(king)];
+
+  u64 queens = board.getPieces(C, QUEEN);
+  return attacks | sliderAttacks(board.getPieces(C, BISHOP) | queens,
+                                 board.getPieces(C, ROOK) | queens, occupied);
+}
 
-    if ((fromBB & pinnedPieces) != 0) {
-      continue;
-    }
+template u64 validMoveBB::attacksBy<WHITE>(const Board &, u64);
+template u64 validMoveBB::attacksBy<BLACK>(const Board &, u64);
+
+namespace {
+
+// Piece kinds a legal generator call covers, one bit per PieceKind
+constexpr int ALL_KINDS = 0x3F;
+
+// Legality constraints of one side, computed once per position. Every legal
+// generator below restricts its destinations with them instead of making and
+// unmaking moves. The side itself is the template parameter of the
+// generators.
+struct LegalMasks {
+  u64 ownPieces;
+  u64 enemyPieces;
+  u64 allPieces;
+  Square kingSquare; // SQ_NONE in kingless test positions
+  u64 checkers;      // Enemy pieces giving check
+  u64 pinned;        // Own pieces pinned to the king
+  u64 targets;       // Destinations that also capture or block a lone checker
+  u64 sources;       // Pieces allowed to move
+  GenType type;
+};
+
+// Returns the pieces of color By attacking a square under the given occupancy
+template <Color By>
+u64 attackersOf(const Board &board, Square sq, u64 occupied) {
+  return board.attackersTo(sq, occupied) & board.getOccupancy(By);
+}
 
-    if (!inCheck) {
-      legal.push_back(move);
-      continue;
-    }
+template <Color Us>
+LegalMasks computeLegalMasks(Board &board, GenType type) {
+  constexpr Color Them = ~Us;
+  LegalMasks m;
+  m.type = type;
+  m.sources = ~0ULL;
+  m.ownPieces = board.getOccupancy(Us);
+  m.enemyPieces = board.getOccupancy(Them);
+  m.allPieces = board.getAllPieces();
+  m.checkers = 0ULL;
+  m.pinned = 0ULL;
+  m.targets = ~m.ownPieces;
+
+  u64 king = board.getPieces(Us, KING);
+  m.kingSquare = king ? Utils::bitboardToSquare(king) : SQ_NONE;
+  if (m.kingSquare == SQ_NONE)
+    return m;
+
+  // The board caches the checkers of the side to move only
+  m.checkers = board.getWhiteToMove() == (Us == WHITE)
+                   ? board.getCheckers()
+                   : attackersOf<Them>(board, m.kingSquare, m.allPieces);
+  m.pinned = board.pinnedPieces<Us>();
+
+  if (Utils::isOneBit(m.checkers))
+    m.targets &= m.checkers | Magic::betweenSquares(
+                                  m.kingSquare,
+                                  Utils::bitboardToSquare(m.checkers));
+  else if (m.checkers)
+    m.targets = 0ULL; // Double check: only the king may move
+  return m;
+}
 
-    board.makeMove(move);
-    if (!board.isKingChecked(isWhite)) {
-      legal.push_back(move);
-    }
-    board.undoMove();
-  }
+// Destinations of non-pawn moves allowed by the generation type
+inline u64 typeMask(const LegalMasks &m) {
+  return m.type == GEN_CAPTURES ? m.enemyPieces
+         : m.type == GEN_QUIETS ? ~m.allPieces
+                                : ~0ULL;
+}
 
-  return legal;
+// Restricts the destinations of a pinned piece to its pin ray
+inline u64 pinRay(const LegalMasks &m, Square from) {
+  return (m.pinned & Utils::squareToBitboard(from))
+             ? Magic::lineThrough(m.kingSquare, from)
+             : ~0ULL;
 }
-// Generates a list of legal bishop moves
-std::vector<Move> MoveGeneration::generateBishopLegalMoves(Board &board,
-                                                           bool isWhite,
-                                                           bool inCheck,
-                                                           u64 pinnedPieces) {
-  std::vector<Move> pseudoLegal = generateBishopMoves(board, isWhite);
 
-  if (!inCheck && pinnedPieces == 0ULL) {
-    return pseudoLegal;
+inline void addMoves(const LegalMasks &m, Square from, u64 destinations,
+                     MoveList &moves) {
+  while (destinations) {
+    Square to = Utils::popLSB(destinations);
+    bool isCapture = (m.enemyPieces & Utils::squareToBitboard(to)) != 0;
+    moves.emplace_back(from, to, isCapture ? CAPTURE : QUIET_MOVE);
   }
+}
 
-  std::vector<Move> legal;
-  legal.reserve(pseudoLegal.size());
-
-  for (const Move &move : pseudoLegal) {
-    Square fromSq = move.getFromSquare();
-    u64 fromBB = Utils::squareToBitboard(fromSq);
+template <Color Us>
+void addLegalEnPassant(Board &board, const LegalMasks &m, MoveList &moves);
+
+template <Color Us>
+void addLegalPawnMoves(Board &board, const LegalMasks &m, MoveList &moves) {
+  u64 pawns = board.getPieces(Us, PAWN) & m.sources;
+
+  // Free pawns move as one set; each pinned pawn keeps to its own pin ray
+  addPawnMovesSetwise<Us>(pawns & ~m.pinned, m.allPieces, m.enemyPieces,
+                          m.targets, m.type, moves);
+  u64 pinnedPawns = pawns & m.pinned;
+  while (pinnedPawns) {
+    Square from = Utils::popLSB(pinnedPawns);
+    addPawnMovesSetwise<Us>(Utils::squareToBitboard(from), m.allPieces,
+                            m.enemyPieces, m.targets & pinRay(m, from),
+                            m.type, moves);
+  }
 
-    if (!inCheck && (fromBB & pinnedPieces) == 0) {
-      legal.push_back(move);
-      continue;
-    }
+  addLegalEnPassant<Us>(board, m, moves);
+}
 
-    board.makeMove(move);
-    if (!board.isKingChecked(isWhite)) {
-      legal.push_back(move);
+// En passant. The target square only belongs to us if it sits on our sixth
+// rank, which matters when generating for the side not to move.
+template <Color Us>
+void addLegalEnPassant(Board &board, const LegalMasks &m, MoveList &moves) {
+  constexpr Color Them = ~Us;
+  if (m.type == GEN_QUIETS)
+    return;
+  Square epSquare = board.getEnPassantSquare();
+  if (epSquare == SQ_NONE || Utils::getRank(epSquare) != (Us == WHITE ? 5 : 2))
+    return;
+  Square capturedSquare =
+      static_cast<Square>(Us == WHITE ? epSquare - 8 : epSquare + 8);
+  u64 epBB = Utils::squareToBitboard(epSquare);
+  u64 capturedBB = Utils::squareToBitboard(capturedSquare);
+
+  // In check, the capture must remove the checking pawn or block the check
+  if (!(m.targets & epBB) && !(m.checkers & capturedBB))
+    return;
+
+  u64 capturers = Tables::PawnAttacks[Them][epSquare] &
+                  board.getPieces(Us, PAWN) & m.sources;
+  u64 diagonal = board.getPieces(Them, BISHOP) | board.getPieces(Them, QUEEN);
+  u64 straight = board.getPieces(Them, ROOK) | board.getPieces(Them, QUEEN);
+
+  while (capturers) {
+    Square from = Utils::popLSB(capturers);
+
+    // Both pawns leave their squares at once, which can uncover a slider on
+    // the king's rank that no pin detects. Test the final occupancy directly.
+    if (m.kingSquare != SQ_NONE) {
+      u64 occupied =
+          (m.allPieces ^ Utils::squareToBitboard(from) ^ capturedBB) | epBB;
+      if ((Magic::getBishopAttacks(m.kingSquare, occupied) & diagonal) ||
+          (Magic::getRookAttacks(m.kingSquare, occupied) & straight))
+        continue;
     }
-    board.undoMove();
+    moves.emplace_back(from, epSquare, EN_PASSANT);
   }
-
-  return legal;
 }
 
-// Generates a list of legal rook moves
-std::vector<Move> MoveGeneration::generateRookLegalMoves(Board &board,
-                                                         bool isWhite,
-                                                         bool inCheck,
-                                                         u64 pinnedPieces) {
-  std::vector<Move> pseudoLegal = generateRookMoves(board, isWhite);
+template <Color Us>
+void addLegalKnightMoves(Board &board, const LegalMasks &m, MoveList &moves) {
+  // A pinned knight can never stay on its pin ray
+  u64 knights = board.getPieces(Us, KNIGHT) & m.sources & ~m.pinned;
+  while (knights) {
+    Square from = Utils::popLSB(knights);
+    u64 destinations = Tables::KnightAttacks[from] & ~m.ownPieces &
+                       m.targets & typeMask(m);
+    addMoves(m, from, destinations, moves);
+  }
+}
 
-  if (!inCheck && pinnedPieces == 0ULL) {
-    return pseudoLegal;
+template <Color Us, PieceKind Kind>
+void addLegalSliderMoves(Board &board, const LegalMasks &m, MoveList &moves) {
+  u64 sliders = board.getPieces(Us, Kind) & m.sources;
+  while (sliders) {
+    Square from = Utils::popLSB(sliders);
+    u64 attacks = 0ULL;
+    if constexpr (Kind != ROOK)
+      attacks |= Magic::getBishopAttacks(from, m.allPieces);
+    if constexpr (Kind != BISHOP)
+      attacks |= Magic::getRookAttacks(from, m.allPieces);
+    addMoves(m, from, attacks & m.targets & typeMask(m) & pinRay(m, from),
+             moves);
   }
+}
 
-  std::vector<Move> legal;
-  legal.reserve(pseudoLegal.size());
+template <Color Us>
+void addLegalKingMoves(Board &board, const LegalMasks &m, MoveList &moves) {
+  if (m.kingSquare == SQ_NONE ||
+      !(m.sources & Utils::squareToBitboard(m.kingSquare)))
+    return;
+
+  // Squares attacked with the king lifted off the board, so that stepping
+  // back along a checking slider's ray is not mistaken for safe
+  u64 king = Utils::squareToBitboard(m.kingSquare);
+  u64 danger = validMoveBB::attacksBy<~Us>(board, m.allPieces ^ king);
+  addMoves(m, m.kingSquare,
+           Tables::KingAttacks[m.kingSquare] & ~m.ownPieces & ~danger &
+               typeMask(m),
+           moves);
+
+  if (m.checkers || m.type == GEN_CAPTURES)
+    return;
+
+  // Castling: rights, king and rook at home, an empty path and no attacked
+  // square under the king's feet
+  constexpr Square home = Us == WHITE ? E1 : E8;
+  constexpr int kingSide = Us == WHITE ? WHITE_KS : BLACK_KS;
+  constexpr int queenSide = Us == WHITE ? WHITE_QS : BLACK_QS;
+  u64 rooks = board.getPieces(Us, ROOK);
+  int rights = board.getCastlingRights();
+  if (m.kingSquare != home)
+    return;
+
+  constexpr u64 rookKS = 1ULL << (home + 3);
+  constexpr u64 pathKS = (1ULL << (home + 1)) | (1ULL << (home + 2));
+  if ((rights & kingSide) && (rooks & rookKS) && !(m.allPieces & pathKS) &&
+      !(danger & pathKS))
+    moves.emplace_back(home, static_cast<Square>(home + 2), KING_CASTLE);
+
+  constexpr u64 rookQS = 1ULL << (home - 4);
+  constexpr u64 kingPathQS = (1ULL << (home - 1)) | (1ULL << (home - 2));
+  constexpr u64 emptyQS = kingPathQS | (1ULL << (home - 3));
+  if ((rights & queenSide) && (rooks & rookQS) && !(m.allPieces & emptyQS) &&
+      !(danger & kingPathQS))
+    moves.emplace_back(home, static_cast<Square>(home - 2), QUEEN_CASTLE);
+}
 
-  for (const Move &move : pseudoLegal) {
-    Square fromSq = move.getFromSquare();
-    u64 fromBB = Utils::squareToBitboard(fromSq);
+// Generates the legal moves of the piece kinds in 'kinds'
+template <Color Us>
+void addLegalMoves(Board &board, const LegalMasks &m, int kinds,
+                   MoveList &moves) {
+  // In double check only the king can move
+  if (m.targets) {
+    if (kinds & (1 << PAWN))
+      addLegalPawnMoves<Us>(board, m, moves);
+    if (kinds & (1 << KNIGHT))
+      addLegalKnightMoves<Us>(board, m, moves);
+    if (kinds & (1 << BISHOP))
+      addLegalSliderMoves<Us, BISHOP>(board, m, moves);
+    if (kinds & (1 << ROOK))
+      addLegalSliderMoves<Us, ROOK>(board, m, moves);
+    if (kinds & (1 << QUEEN))
+      addLegalSliderMoves<Us, QUEEN>(board, m, moves);
+  }
+  if (kinds & (1 << KING))
+    addLegalKingMoves<Us>(board, m, moves);
+}
 
-    if (!inCheck && (fromBB & pinnedPieces) == 0) {
-      legal.push_back(move);
-      continue;
+// Generates the legal replies to a check: king escapes and, against a
+// single checker, captures of it and interpositions on the squares between.
+// The pieces that can reach those few target squares are found by looking
+// back from them.
+template <Color Us>
+void addEvasions(Board &board, const LegalMasks &m, MoveList &moves) {
+  addLegalKingMoves<Us>(board, m, moves);
+  if (!m.targets)
+    return; // Double check
+
+  // A pinned piece can only help by taking the checker along its pin ray,
+  // which happens when the checker stands between it and the king
+  u64 pawns = board.getPieces(Us, PAWN);
+  addPawnMovesSetwise<Us>(pawns & ~m.pinned, m.allPieces, m.enemyPieces,
+                          m.targets, m.type, moves);
+  u64 pinnedPawns = pawns & m.pinned;
+  while (pinnedPawns) {
+    Square from = Utils::popLSB(pinnedPawns);
+    addPawnMovesSetwise<Us>(Utils::squareToBitboard(from), m.allPieces,
+                            m.enemyPieces, m.targets & pinRay(m, from),
+                            m.type, moves);
+  }
+  addLegalEnPassant<Us>(board, m, moves);
+
+  u64 knights = board.getPieces(Us, KNIGHT) & ~m.pinned;
+  u64 queens = board.getPieces(Us, QUEEN);
+  u64 diagonal = board.getPieces(Us, BISHOP) | queens;
+  u64 straight = board.getPieces(Us, ROOK) | queens;
+  u64 targets = m.targets & typeMask(m);
+  while (targets) {
+    Square to = Utils::popLSB(targets);
+    u64 toBB = Utils::squareToBitboard(to);
+    u64 defenders = (Tables::KnightAttacks[to] & knights) |
+                    (Magic::getBishopAttacks(to, m.allPieces) & diagonal) |
+                    (Magic::getRookAttacks(to, m.allPieces) & straight);
+    MoveFlag flag = (m.enemyPieces & toBB) ? CAPTURE : QUIET_MOVE;
+    while (defenders) {
+      Square from = Utils::popLSB(defenders);
+      if (pinRay(m, from) & toBB)
+        moves.emplace_back(from, to, flag);
     }
+  }
+}
 
-    board.makeMove(move);
-    if (!board.isKingChecked(isWhite)) {
-      legal.push_back(move);
+// Generates the legal quiet moves of the side to move that give check.
+// Direct checks land on the check squares the board keeps for each piece
+// kind; discovered checks move one of our blockers of the enemy king off its
+// line. Castling is tested separately, with the king and rook in place.
+template <Color Us>
+void addQuietChecks(Board &board, MoveList &moves) {
+  u64 theirKing = board.getPieces(~Us, KING);
+  if (!theirKing)
+    return;
+  Square kingSquare = Utils::bitboardToSquare(theirKing);
+  LegalMasks m = computeLegalMasks<Us>(board, GEN_QUIETS);
+  u64 discoverers = board.getBlockersForKing(~Us) & m.ownPieces;
+
+  // Any move of a discoverer that leaves the line uncovers the check
+  if (discoverers) {
+    LegalMasks d = m;
+    d.sources = discoverers;
+    MoveList candidates;
+    addLegalMoves<Us>(board, d, ALL_KINDS, candidates);
+    for (Move move : candidates) {
+      Square from = move.getFromSquare();
+      u64 toBB = Utils::squareToBitboard(move.getToSquare());
+      PieceKind kind = kindOf(board.pieceOn(from));
+      if (!move.isCastling() &&
+          (!(Magic::lineThrough(kingSquare, from) & toBB) ||
+           (kind != KING && (board.getCheckSquares(kind) & toBB))))
+        moves.push_back(move);
     }
-    board.undoMove();
   }
 
-  return legal;
-}
-
-// Generates a list of legal queen moves
-std::vector<Move> MoveGeneration::generateQueenLegalMoves(Board &board,
-                                                          bool isWhite,
-                                                          bool inCheck,
-                                                          u64 pinnedPieces) {
-  std::vector<Move> pseudoLegal = generateQueenMoves(board, isWhite);
+  // Direct checks from the remaining pieces
+  LegalMasks c = m;
+  c.sources = ~discoverers;
+  for (PieceKind kind : {PAWN, KNIGHT, BISHOP, ROOK, QUEEN}) {
+    c.targets = m.targets & board.getCheckSquares(kind);
+    if (c.targets)
+      addLegalMoves<Us>(board, c, 1 << kind, moves);
+  }
 
-  if (!inCheck && pinnedPieces == 0ULL) {
-    return pseudoLegal;
+  // Castling checks through the rook on its new square, or by moving the
+  // king off a line it was blocking
+  constexpr Square home = Us == WHITE ? E1 : E8;
+  if (m.kingSquare != home)
+    return;
+  LegalMasks k = m;
+  k.sources = Utils::squareToBitboard(home);
+  MoveList candidates;
+  addLegalKingMoves<Us>(board, k, candidates);
+  u64 queens = board.getPieces(Us, QUEEN);
+  u64 diagonal = board.getPieces(Us, BISHOP) | queens;
+  for (Move move : candidates) {
+    if (!move.isCastling())
+      continue;
+    bool kingSide = move.getIsKingSideCastle();
+    u64 rookMove = kingSide ? (1ULL << (home + 3)) | (1ULL << (home + 1))
+                            : (1ULL << (home - 4)) | (1ULL << (home - 1));
+    u64 kingMove = k.sources | Utils::squareToBitboard(move.getToSquare());
+    u64 occupied = m.allPieces ^ rookMove ^ kingMove;
+    u64 straight = (board.getPieces(Us, ROOK) ^ rookMove) | queens;
+    if ((Magic::getRookAttacks(kingSquare, occupied) & straight) ||
+        (Magic::getBishopAttacks(kingSquare, occupied) & diagonal))
+      moves.push_back(move);
   }
+}
 
-  std::vector<Move> legal;
-  legal.reserve(pseudoLegal.size());
+template <Color Us>
+void generateLegal(Board &board, GenType type, int kinds, u64 sources,
+                   MoveList &moves) {
+  LegalMasks m = computeLegalMasks<Us>(board, type);
+  m.sources = sources;
+  if (m.checkers && kinds == ALL_KINDS && sources == ~0ULL)
+    addEvasions<Us>(board, m, moves);
+  else
+    addLegalMoves<Us>(board, m, kinds, moves);
+}
 
-  for (const Move &move : pseudoLegal) {
-    Square fromSq = move.getFromSquare();
-    u64 fromBB = Utils::squareToBitboard(fromSq);
+// Resolves the side once and runs the generator for it
+inline void generateLegal(Board &board, bool isWhite, GenType type, int kinds,
+                          u64 sources, MoveList &moves) {
+  if (isWhite)
+    generateLegal<WHITE>(board, type, kinds, sources, moves);
+  else
+    generateLegal<BLACK>(board, type, kinds, sources, moves);
+}
 
-    if (!inCheck && (fromBB & pinnedPieces) == 0) {
-      legal.push_back(move);
-      continue;
-    }
+} // namespace
 
-    board.makeMove(move);
-    if (!board.isKingChecked(isWhite)) {
-      legal.push_back(move);
-    }
-    board.undoMove();
-  }
+// Generates all legal moves for the given side
+void MoveGeneration::generateAllMoves(Board &board, bool isWhite,
+                                      MoveList &moves) {
+  generateLegal(board, isWhite, GEN_ALL, ALL_KINDS, ~0ULL, moves);
+}
 
-  return legal;
+// Generates the legal replies to a check on the side to move
+void MoveGeneration::generateEvasions(Board &board, MoveList &moves) {
+  if (board.getWhiteToMove())
+    addEvasions<WHITE>(board, computeLegalMasks<WHITE>(board, GEN_ALL), moves);
+  else
+    addEvasions<BLACK>(board, computeLegalMasks<BLACK>(board, GEN_ALL), moves);
 }
 
-// Generates all legal moves for the current player
-std::vector<Move> MoveGeneration::generateAllMoves(Board &board, bool isWhite) {
-  std::vector<Move> allMoves;
-
-  bool inCheck = board.isKingChecked(isWhite);
-  u64 pinnedPieces = board.getPinnedPieces(isWhite);
-
-  std::vector<Move> pawnMoves =
-      generatePawnLegalMoves(board, isWhite, inCheck, pinnedPieces);
-  std::vector<Move> knightMoves =
-      generateKnightLegalMoves(board, isWhite, inCheck, pinnedPieces);
-  std::vector<Move> bishopMoves =
-      generateBishopLegalMoves(board, isWhite, inCheck, pinnedPieces);
-  std::vector<Move> rookMoves =
-      generateRookLegalMoves(board, isWhite, inCheck, pinnedPieces);
-  std::vector<Move> queenMoves =
-      generateQueenLegalMoves(board, isWhite, inCheck, pinnedPieces);
-  std::vector<Move> kingMoves = generateKingLegalMoves(board, isWhite);
-
-  allMoves.insert(allMoves.end(), pawnMoves.begin(), pawnMoves.end());
-  allMoves.insert(allMoves.end(), knightMoves.begin(), knightMoves.end());
-  allMoves.insert(allMoves.end(), bishopMoves.begin(), bishopMoves.end());
-  allMoves.insert(allMoves.end(), rookMoves.begin(), rookMoves.end());
-  allMoves.insert(allMoves.end(), queenMoves.begin(), queenMoves.end());
-  allMoves.insert(allMoves.end(), kingMoves.begin(), kingMoves.end());
-
-  if (inCheck) {
-    if (board.getAttackersCount(isWhite) > 1)
-      return kingMoves;
-    return generateLegalMovesWhileInCheck(board, isWhite, allMoves);
-  }
+// Generates the legal quiet checks of the side to move
+void MoveGeneration::generateQuietChecks(Board &board, MoveList &moves) {
+  if (board.getWhiteToMove())
+    addQuietChecks<WHITE>(board, moves);
+  else
+    addQuietChecks<BLACK>(board, moves);
+}
 
-  return allMoves;
+// Generates the legal captures and promotions of the side to move
+void MoveGeneration::generateLegalCaptures(Board &board, MoveList &moves) {
+  generateLegal(board, board.getWhiteToMove(), GEN_CAPTURES, ALL_KINDS, ~0ULL,
+                moves);
 }
-// Filters a list of moves to only include legal moves while in check
-std::vector<Move>
-MoveGeneration::generateLegalMovesWhileInCheck(Board &board, bool isWhite,
-                                               std::vector<Move> allMoves) {
 
-  std::vector<Move> legalMoves;
+// Generates the legal non-capturing, non-promoting moves of the side to move
+void MoveGeneration::generateLegalQuiets(Board &board, MoveList &moves) {
+  generateLegal(board, board.getWhiteToMove(), GEN_QUIETS, ALL_KINDS, ~0ULL,
+                moves);
+}
 
-  for (const Move &move : allMoves) {
-    board.makeMove(move);
-    if (!board.isKingChecked(isWhite)) {
-      legalMoves.push_back(move);
-    }
-    board.undoMove();
-  }
-  return legalMoves;
+// Checks whether a move, for instance one taken from the transposition table,
+// is legal for the side to move. Only the moves of the piece on the origin
+// square are generated.
+bool MoveGeneration::isLegal(Board &board, Move move) {
+  if (move.isNull())
+    return false;
+  Square from = move.getFromSquare();
+  PieceType piece = board.pieceOn(from);
+  bool isWhite = board.getWhiteToMove();
+  if (piece == EMPTY || colorOf(piece) != (isWhite ? WHITE : BLACK))
+    return false;
+
+  MoveList moves;
+  generateLegal(board, isWhite, GEN_ALL, 1 << kindOf(piece),
+                Utils::squareToBitboard(from), moves);
+  return moves.contains(move);
 }
 
 // Generates a list of legal castling moves
-std::vector<Move> MoveGeneration::generateCastlingMoves(Board &board,
-                                                        bool isWhite) {
-
-  std::vector<Move> castlingMoves;
-  PieceType king = isWhite ? WHITE_KING : BLACK_KING;
+void MoveGeneration::generateCastlingMoves(Board &board, bool isWhite,
+                                           MoveList &moves) {
 
   if (board.canCastleKingSide(isWhite)) {
     if (isWhite)
-      castlingMoves.emplace_back(E1, G1, king, EMPTY, false, true, false, false,
-                                 EMPTY);
+      moves.emplace_back(E1, G1, KING_CASTLE);
 
     else
-      castlingMoves.emplace_back(E8, G8, king, EMPTY, false, true, false, false,
-                                 EMPTY);
+      moves.emplace_back(E8, G8, KING_CASTLE);
   }
   if (board.canCastleQueenSide(isWhite)) {
     if (isWhite)
-      castlingMoves.emplace_back(E1, C1, king, EMPTY, false, false, true, false,
-                                 EMPTY);
+      moves.emplace_back(E1, C1, QUEEN_CASTLE);
 
     else
-      castlingMoves.emplace_back(E8, C8, king, EMPTY, false, false, true, false,
-                                 EMPTY);
+      moves.emplace_back(E8, C8, QUEEN_CASTLE);
   }
-  return castlingMoves;
 }
 
-// Generates a list of all possible captures
-std::vector<Move> MoveGeneration::generateCaptures(Board &board, bool isWhite) {
-  std::vector<Move> captures;
+// Generates a list of all possible moves
+void MoveGeneration::generateCaptures(Board &board, bool isWhite,
+                                      MoveList &moves) {
 
   u64 ownPieces =
       isWhite ? board.getAllWhitePieces() : board.getAllBlackPieces();
   u64 enemyPieces =
       isWhite ? board.getAllBlackPieces() : board.getAllWhitePieces();
 
+  // Pawn captures; promotions are generated separately
   u64 pawns = isWhite ? board.getWhitePawns() : board.getBlackPawns();
   u64 nonPromoPawns =
       isWhite ? pawns & ~Tables::maskRank[6] : pawns & ~Tables::maskRank[1];
-  PieceType pawnPiece = isWhite ? WHITE_PAWN : BLACK_PAWN;
-
-  while (nonPromoPawns) {
-    Square fromSq = Utils::popLSB(nonPromoPawns);
-    u64 pawn = Utils::squareToBitboard(fromSq);
-    u64 attacks = isWhite ? validMoveBB::whitePawnAttacks(pawn)
-                          : validMoveBB::blackPawnAttacks(pawn);
-
-    u64 pawnCaptures = attacks & enemyPieces;
-    while (pawnCaptures) {
-      Square toSq = Utils::popLSB(pawnCaptures);
-      PieceType captured = Utils::getPieceTypeAt(board, toSq);
-      captures.emplace_back(fromSq, toSq, pawnPiece, captured, false, false,
-                            false, false, EMPTY);
-    }
-  }
+  addPawnMovesSetwise(isWhite, nonPromoPawns, board.getAllPieces(),
+                      enemyPieces, ~0ULL, GEN_CAPTURES, moves);
 
-  std::vector<Move> epMoves = generateEnPassantMoves(board, isWhite);
-  captures.insert(captures.end(), epMoves.begin(), epMoves.end());
+  generateEnPassantMoves(board, isWhite, moves);
 
   u64 knights = isWhite ? board.getWhiteKnights() : board.getBlackKnights();
-  PieceType knightPiece = isWhite ? WHITE_KNIGHT : BLACK_KNIGHT;
   while (knights) {
     Square fromSq = Utils::popLSB(knights);
-    u64 knight = Utils::squareToBitboard(fromSq);
-    u64 attacks = validMoveBB::knightMoves(knight, ownPieces);
-    u64 knightCaptures = attacks & enemyPieces;
+    u64 knightCaptures = Tables::KnightAttacks[fromSq] & enemyPieces;
 
     while (knightCaptures) {
       Square toSq = Utils::popLSB(knightCaptures);
-      PieceType captured = Utils::getPieceTypeAt(board, toSq);
-      captures.emplace_back(fromSq, toSq, knightPiece, captured, false, false,
-                            false, false, EMPTY);
+      moves.emplace_back(fromSq, toSq, CAPTURE);
     }
   }
 
   u64 bishops = isWhite ? board.getWhiteBishops() : board.getBlackBishops();
-  PieceType bishopPiece = isWhite ? WHITE_BISHOP : BLACK_BISHOP;
   while (bishops) {
     Square fromSq = Utils::popLSB(bishops);
     u64 bishop = Utils::squareToBitboard(fromSq);
@@ -875,14 +996,11 @@ std::vector<Move> MoveGeneration::generateCaptures(Board &board, bool isWhite) {
 
     while (bishopCaptures) {
       Square toSq = Utils::popLSB(bishopCaptures);
-      PieceType captured = Utils::getPieceTypeAt(board, toSq);
-      captures.emplace_back(fromSq, toSq, bishopPiece, captured, false, false,
-                            false, false, EMPTY);
+      moves.emplace_back(fromSq, toSq, CAPTURE);
     }
   }
 
   u64 rooks = isWhite ? board.getWhiteRooks() : board.getBlackRooks();
-  PieceType rookPiece = isWhite ? WHITE_ROOK : BLACK_ROOK;
   while (rooks) {
     Square fromSq = Utils::popLSB(rooks);
     u64 rook = Utils::squareToBitboard(fromSq);
@@ -891,14 +1009,11 @@ std::vector<Move> MoveGeneration::generateCaptures(Board &board, bool isWhite) {
 
     while (rookCaptures) {
       Square toSq = Utils::popLSB(rookCaptures);
-      PieceType captured = Utils::getPieceTypeAt(board, toSq);
-      captures.emplace_back(fromSq, toSq, rookPiece, captured, false, false,
-                            false, false, EMPTY);
+      moves.emplace_back(fromSq, toSq, CAPTURE);
     }
   }
 
   u64 queens = isWhite ? board.getWhiteQueens() : board.getBlackQueens();
-  PieceType queenPiece = isWhite ? WHITE_QUEEN : BLACK_QUEEN;
   while (queens) {
     Square fromSq = Utils::popLSB(queens);
     u64 queen = Utils::squareToBitboard(fromSq);
@@ -907,24 +1022,143 @@ std::vector<Move> MoveGeneration::generateCaptures(Board &board, bool isWhite) {
 
     while (queenCaptures) {
       Square toSq = Utils::popLSB(queenCaptures);
-      PieceType captured = Utils::getPieceTypeAt(board, toSq);
-      captures.emplace_back(fromSq, toSq, queenPiece, captured, false, false,
-                            false, false, EMPTY);
+      moves.emplace_back(fromSq, toSq, CAPTURE);
     }
   }
 
   u64 king = isWhite ? board.getWhiteKing() : board.getBlackKing();
-  PieceType kingPiece = isWhite ? WHITE_KING : BLACK_KING;
+  if (!king)
+    return;
   Square kingSq = Utils::bitboardToSquare(king);
-  u64 attacks = validMoveBB::kingMoves(king, ownPieces);
-  u64 kingCaptures = attacks & enemyPieces;
+  u64 kingCaptures = Tables::KingAttacks[kingSq] & enemyPieces;
 
   while (kingCaptures) {
     Square toSq = Utils::popLSB(kingCaptures);
-    PieceType captured = Utils::getPieceTypeAt(board, toSq);
-    captures.emplace_back(kingSq, toSq, kingPiece, captured, false, false,
-                          false, false, EMPTY);
+    moves.emplace_back(kingSq, toSq, CAPTURE);
   }
 
-  return captures;
+}
+
+// --- std::vector overloads for callers outside the search ---
+
+static std::vector<Move> toVector(const MoveList &moves) {
+  return std::vector<Move>(moves.begin(), moves.end());
+}
+
+std::vector<Move> MoveGeneration::generateKingMoves(Board &board,
+                                                    bool isWhite) {
+  MoveList moves;
+  generateKingMoves(board, isWhite, moves);
+  return toVector(moves);
+}
+
+std::vector<Move> MoveGeneration::generateKnightMoves(Board &board,
+                                                      bool isWhite) {
+  MoveList moves;
+  generateKnightMoves(board, isWhite, moves);
+  return toVector(moves);
+}
+
+std::vector<Move> MoveGeneration::generatePawnMoves(Board &board,
+                                                    bool isWhite) {
+  MoveList moves;
+  generatePawnMoves(board, isWhite, moves);
+  return toVector(moves);
+}
+
+std::vector<Move> MoveGeneration::generateRookMoves(Board &board,
+                                                    bool isWhite) {
+  MoveList moves;
+  generateRookMoves(board, isWhite, moves);
+  return toVector(moves);
+}
+
+std::vector<Move> MoveGeneration::generateBishopMoves(Board &board,
+                                                      bool isWhite) {
+  MoveList moves;
+  generateBishopMoves(board, isWhite, moves);
+  return toVector(moves);
+}
+
+std::vector<Move> MoveGeneration::generateQueenMoves(Board &board,
+                                                     bool isWhite) {
+  MoveList moves;
+  generateQueenMoves(board, isWhite, moves);
+  return toVector(moves);
+}
+
+std::vector<Move> MoveGeneration::generateAllMoves(Board &board, bool isWhite) {
+  MoveList moves;
+  generateAllMoves(board, isWhite, moves);
+  return toVector(moves);
+}
+
+std::vector<Move> MoveGeneration::generateKingLegalMoves(Board &board,
+                                                         bool isWhite) {
+  MoveList moves;
+  generateLegal(board, isWhite, GEN_ALL, 1 << KING, ~0ULL, moves);
+  return toVector(moves);
+}
+
+std::vector<Move> MoveGeneration::generatePawnLegalMoves(Board &board,
+                                                         bool isWhite) {
+  MoveList moves;
+  generateLegal(board, isWhite, GEN_ALL, 1 << PAWN, ~0ULL, moves);
+  return toVector(moves);
+}
+
+std::vector<Move> MoveGeneration::generateKnightLegalMoves(Board &board,
+                                                           bool isWhite) {
+  MoveList moves;
+  generateLegal(board, isWhite, GEN_ALL, 1 << KNIGHT, ~0ULL, moves);
+  return toVector(moves);
+}
+
+std::vector<Move> MoveGeneration::generateBishopLegalMoves(Board &board,
+                                                           bool isWhite) {
+  MoveList moves;
+  generateLegal(board, isWhite, GEN_ALL, 1 << BISHOP, ~0ULL, moves);
+  return toVector(moves);
+}
+
+std::vector<Move> MoveGeneration::generateRookLegalMoves(Board &board,
+                                                         bool isWhite) {
+  MoveList moves;
+  generateLegal(board, isWhite, GEN_ALL, 1 << ROOK, ~0ULL, moves);
+  return toVector(moves);
+}
+
+std::vector<Move> MoveGeneration::generateQueenLegalMoves(Board &board,
+                                                          bool isWhite) {
+  MoveList moves;
+  generateLegal(board, isWhite, GEN_ALL, 1 << QUEEN, ~0ULL, moves);
+  return toVector(moves);
+}
+
+std::vector<Move> MoveGeneration::generatePawnPromotionMoves(Board &board,
+                                                             u64 pawnLoc,
+                                                             bool isWhite) {
+  MoveList moves;
+  generatePawnPromotionMoves(board, pawnLoc, isWhite, moves);
+  return toVector(moves);
+}
+
+std::vector<Move> MoveGeneration::generateCastlingMoves(Board &board,
+                                                        bool isWhite) {
+  MoveList moves;
+  generateCastlingMoves(board, isWhite, moves);
+  return toVector(moves);
+}
+
+std::vector<Move> MoveGeneration::generateEnPassantMoves(Board &board,
+                                                         bool isWhite) {
+  MoveList moves;
+  generateEnPassantMoves(board, isWhite, moves);
+  return toVector(moves);
+}
+
+std::vector<Move> MoveGeneration::generateCaptures(Board &board, bool isWhite) {
+  MoveList moves;
+  generateCaptures(board, isWhite, moves);
+  return toVector(moves);
 }
@@ -6,62 +6,62 @@
  */
 #include "../include/moveorder.hpp"
 #include "../include/evaluation.hpp"
-#include <algorithm>
 #include <utility>
 
-// Orders all legal moves based on a scoring heuristic
-std::vector<Move> MoveOrder::getOrderedMoves(Board &board) {
-  std::vector<Move> allMoves =
-      MoveGeneration::generateAllMoves(board, board.getWhiteToMove());
-
-  std::vector<std::pair<Move, int>> scoredMoves;
-  scoredMoves.reserve(allMoves.size());
-
-  for (const Move &move : allMoves) {
-    int score = getMoveScore(board, move);
-    scoredMoves.push_back({move, score});
+// Sorts moves by descending score. Insertion sort keeps equal moves in
+// generation order and beats std::sort on lists this short.
+static void sortByScore(MoveList &moves, int *scores) {
+  for (int i = 1; i < moves.size(); i++) {
+    Move move = moves[i];
+    int score = scores[i];
+    int j = i - 1;
+    for (; j >= 0 && scores[j] < score; j--) {
+      moves[j + 1] = moves[j];
+      scores[j + 1] = scores[j];
+    }
+    moves[j + 1] = move;
+    scores[j + 1] = score;
   }
+}
 
-  // Sort moves in descending order of their scores
-  std::sort(scoredMoves.begin(), scoredMoves.end(),
-            [](const std::pair<Move, int> &a, const std::pair<Move, int> &b) {
-              return a.second > b.second;
-            });
-
-  std::vector<Move> orderedMoves;
-  orderedMoves.reserve(scoredMoves.size());
-  for (auto &entry : scoredMoves) {
-    orderedMoves.push_back(entry.first);
-  }
+// Generates all legal moves, ordered by a scoring heuristic
+void MoveOrder::getOrderedMoves(Board &board, MoveList &moves) {
+  MoveGeneration::generateAllMoves(board, board.getWhiteToMove(), moves);
+  orderMoves(board, moves);
+}
 
-  return orderedMoves;
+// Orders a list of moves by the scoring heuristic
+void MoveOrder::orderMoves(Board &board, MoveList &moves) {
+  int scores[MAX_MOVES];
+  for (int i = 0; i < moves.size(); i++)
+    scores[i] = getMoveScore(board, moves[i]);
+  sortByScore(moves, scores);
 }
 
 // Orders a list of captures based on the Most Valuable Victim - Least Valuable
 // Attacker heuristic
-void MoveOrder::orderCaptures(std::vector<Move> &captures) {
-  std::sort(captures.begin(), captures.end(),
-            [&](const Move &a, const Move &b) {
-              return getCaptureScore(a) > getCaptureScore(b);
-            });
+void MoveOrder::orderCaptures(const Board &board, MoveList &captures) {
+  int scores[MAX_MOVES];
+  for (int i = 0; i < captures.size(); i++)
+    scores[i] = getCaptureScore(board, captures[i]);
+  sortByScore(captures, scores);
 }
 
 // Assigns a score to a move for ordering purposes
 int MoveOrder::getMoveScore(Board &board, Move move) {
   int score = 0;
+  PieceType piece = board.movedPiece(move);
 
   // Captures are given the highest priority
   if (move.getIsCapture()) {
-    int victimValue = Evaluation::materialValue[move.getCapturedPiece() - 1];
-    int attackerValue = Evaluation::materialValue[move.getPieceType() - 1];
-
-    score = 100000 + (victimValue * 10 - attackerValue); // MVV-LVA
+    score = 100000 + getCaptureScore(board, move); // MVV-LVA
 
   }
 
   // Promotions are the next highest priority
   else if (move.getIsPromotion()) {
-    score = 90000 + Evaluation::materialValue[move.getPromotionPiece() - 1];
+    score = 90000 +
+            Evaluation::materialValue[kindOf(move.getPromotionPiece())];
   }
 
   // Castling is given a high priority
@@ -74,18 +74,128 @@ int MoveOrder::getMoveScore(Board &board, Move move) {
   }
 
   // Penalize moves to squares attacked by pawns
-  if ((Utils::squareToBitboard(move.getToSquare()) &
-       ((move.getPieceType() >= 1 && move.getPieceType() <= 6)
-            ? validMoveBB::blackPawnAttacks(board.getBlackPawns())
-            : validMoveBB::whitePawnAttacks(board.getWhitePawns()))) != 0)
+  Color us = colorOf(piece);
+  if (Tables::PawnAttacks[us][move.getToSquare()] &
+      board.getPieces(~us, PAWN))
     score -= 1000;
 
   return score;
 }
 
-// Calculates the score for a capture move using MVV-LVA
-int MoveOrder::getCaptureScore(const Move &move) {
-  int victimValue = Evaluation::materialValue[move.getCapturedPiece() - 1];
-  int attackerValue = Evaluation::materialValue[move.getPieceType() - 1];
+// Calculates the score for a capture move using MVV-LVA. Quiet promotions
+// share the capture list and count as capturing nothing.
+int MoveOrder::getCaptureScore(const Board &board, Move move) {
+  int victimValue =
+      move.getIsCapture()
+          ? Evaluation::materialValue[kindOf(board.capturedPiece(move))]
+          : 0;
+  int attackerValue = Evaluation::materialValue[kindOf(board.movedPiece(move))];
   return victimValue * 10 - attackerValue;
 }
+
+// Without an exchange evaluator, a capture counts as losing when the victim is
+// worth less than the capturing piece and is defended, so the capturer can be
+// taken back. Undefended victims stay with the good captures.
+static bool isLosingCapture(const Board &board, Move move) {
+  PieceType moved = board.movedPiece(move);
+  if (move.getIsPromotion() ||
+      Evaluation::materialValue[kindOf(board.capturedPiece(move))] >=
+          Evaluation::materialValue[kindOf(moved)])
+    return false;
+  u64 occupied = board.getAllPieces() ^
+                 Utils::squareToBitboard(move.getFromSquare());
+  return (board.attackersTo(move.getToSquare(), occupied) &
+          board.getOccupancy(~colorOf(moved))) != 0;
+}
+
+MovePicker::MovePicker(Board &board, Move ttMove, const Move *killers)
+    : board(board), ttMove(ttMove), stage(TT_STAGE) {
+  this->killers[0] = killers ? killers[0] : Move();
+  this->killers[1] = killers ? killers[1] : Move();
+}
+
+Move MovePicker::selectBest() {
+  int best = current;
+  for (int i = current + 1; i < moves.size(); i++)
+    if (scores[i] > scores[best])
+      best = i;
+  std::swap(moves[current], moves[best]);
+  std::swap(scores[current], scores[best]);
+  return moves[current++];
+}
+
+bool MovePicker::isKiller(Move move) const {
+  return move == killers[0] || move == killers[1];
+}
+
+Move MovePicker::next() {
+  switch (stage) {
+  case TT_STAGE:
+    stage = GEN_CAPTURES;
+    // A TT move may come from a hash collision, so check it before use
+    if (!ttMove.isNull() && MoveGeneration::isLegal(board, ttMove))
+      return ttMove;
+    ttMove = Move();
+    [[fallthrough]];
+
+  case GEN_CAPTURES:
+    MoveGeneration::generateLegalCaptures(board, moves);
+    for (int i = 0; i < moves.size(); i++)
+      scores[i] = MoveOrder::getMoveScore(board, moves[i]);
+    stage = GOOD_CAPTURES;
+    [[fallthrough]];
+
+  case GOOD_CAPTURES:
+    while (current < moves.size()) {
+      Move move = selectBest();
+      if (move == ttMove)
+        continue;
+      // Losing captures are tried after the quiet moves
+      if (isLosingCapture(board, move)) {
+        badCaptures.push_back(move);
+        continue;
+      }
+      return move;
+    }
+    stage = KILLERS;
+    [[fallthrough]];
+
+  case KILLERS:
+    while (killerIndex < 2) {
+      Move killer = killers[killerIndex++];
+      if (!killer.isNull() && killer != ttMove &&
+          MoveGeneration::isLegal(board, killer))
+        return killer;
+    }
+    stage = GEN_QUIETS;
+    [[fallthrough]];
+
+  case GEN_QUIETS:
+    moves.clear();
+    current = 0;
+    MoveGeneration::generateLegalQuiets(board, moves);
+    for (int i = 0; i < moves.size(); i++)
+      scores[i] = MoveOrder::getMoveScore(board, moves[i]);
+    stage = QUIETS;
+    [[fallthrough]];
+
+  case QUIETS:
+    while (current < moves.size()) {
+      Move move = selectBest();
+      if (move != ttMove && !isKiller(move))
+        return move;
+    }
+    stage = BAD_CAPTURES;
+    [[fallthrough]];
+
+  case BAD_CAPTURES:
+    if (badCurrent < badCaptures.size())
+      return badCaptures[badCurrent++];
+    stage = DONE;
+    [[fallthrough]];
+
+  case DONE:
+  default:
+    return Move();
+  }
+}
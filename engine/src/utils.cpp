@@ -42,8 +42,6 @@ int Utils::getCaptureCount(Board &board, PieceType pieceType, bool isWhite) {
   case WHITE_KNIGHT:
   case BLACK_KNIGHT: {
     u64 knightLoc = isWhite ? board.getWhiteKnights() : board.getBlackKnights();
-    u64 ownPieces =
-        isWhite ? board.getAllWhitePieces() : board.getAllBlackPieces();
     u64 enemyPieces =
         isWhite ? board.getAllBlackPieces() : board.getAllWhitePieces();
 
@@ -52,9 +50,7 @@ int Utils::getCaptureCount(Board &board, PieceType pieceType, bool isWhite) {
 
     while (knights) {
       Square knightSquare = Utils::popLSB(knights);
-      u64 singleKnight = Utils::squareToBitboard(knightSquare);
-      u64 knightMoveBB = validMoveBB::knightMoves(singleKnight, ownPieces);
-      allCaptures |= (enemyPieces & knightMoveBB);
+      allCaptures |= enemyPieces & Tables::KnightAttacks[knightSquare];
     }
 
     captureCount = Utils::popcount(allCaptures);
@@ -133,7 +129,10 @@ int Utils::getCaptureCount(Board &board, PieceType pieceType, bool isWhite) {
         isWhite ? board.getAllWhitePieces() : board.getAllBlackPieces();
     u64 enemyPieces =
         isWhite ? board.getAllBlackPieces() : board.getAllWhitePieces();
-    u64 kingMoveBB = validMoveBB::kingMoves(kingLoc, ownPieces);
+    u64 kingMoveBB =
+        kingLoc ? Tables::KingAttacks[Utils::bitboardToSquare(kingLoc)] &
+                      ~ownPieces
+                : 0ULL;
 
     u64 capturedPieces = enemyPieces & kingMoveBB;
 
@@ -148,7 +147,7 @@ int Utils::getCaptureCount(Board &board, PieceType pieceType, bool isWhite) {
 }
 
 // Converts a string in algebraic notation (e.g., "e4") to a square index
-Square Utils::stringToSquare(const std::string &square) {
+Square Utils::stringToSquare(std::string_view square) {
   if (square.length() != 2)
     return SQ_NONE;
 
@@ -196,64 +195,12 @@ PieceType Utils::charToPiece(char c) {
 
 // Counts the number of pieces of a given type on the board
 int Utils::getPieceCount(Board &board, PieceType pieceType) {
-  switch (pieceType) {
-  case WHITE_PAWN:
-    return Utils::popcount(board.getWhitePawns());
-  case WHITE_KNIGHT:
-    return Utils::popcount(board.getWhiteKnights());
-  case WHITE_BISHOP:
-    return Utils::popcount(board.getWhiteBishops());
-  case WHITE_ROOK:
-    return Utils::popcount(board.getWhiteRooks());
-  case WHITE_QUEEN:
-    return Utils::popcount(board.getWhiteQueens());
-  case WHITE_KING:
-    return Utils::popcount(board.getWhiteKing());
-  case BLACK_PAWN:
-    return Utils::popcount(board.getBlackPawns());
-  case BLACK_KNIGHT:
-    return Utils::popcount(board.getBlackKnights());
-  case BLACK_BISHOP:
-    return Utils::popcount(board.getBlackBishops());
-  case BLACK_ROOK:
-    return Utils::popcount(board.getBlackRooks());
-  case BLACK_QUEEN:
-    return Utils::popcount(board.getBlackQueens());
-  case BLACK_KING:
-    return Utils::popcount(board.getBlackKing());
-  default:
+  if (pieceType == EMPTY)
     return 0;
-  }
+  return board.getPieceCount(pieceType);
 }
 
 // Returns the type of piece at a given square
 PieceType Utils::getPieceTypeAt(Board &board, Square square) {
-  u64 squareBB = squareToBitboard(square);
-
-  if (board.getWhitePawns() & squareBB)
-    return WHITE_PAWN;
-  if (board.getBlackPawns() & squareBB)
-    return BLACK_PAWN;
-  if (board.getWhiteKnights() & squareBB)
-    return WHITE_KNIGHT;
-  if (board.getBlackKnights() & squareBB)
-    return BLACK_KNIGHT;
-  if (board.getWhiteBishops() & squareBB)
-    return WHITE_BISHOP;
-  if (board.getBlackBishops() & squareBB)
-    return BLACK_BISHOP;
-  if (board.getWhiteRooks() & squareBB)
-    return WHITE_ROOK;
-  if (board.getBlackRooks() & squareBB)
-    return BLACK_ROOK;
-  if (board.getWhiteQueens() & squareBB)
-    return WHITE_QUEEN;
-  if (board.getBlackQueens() & squareBB)
-    return BLACK_QUEEN;
-  if (board.getWhiteKing() & squareBB)
-    return WHITE_KING;
-  if (board.getBlackKing() & squareBB)
-    return BLACK_KING;
-
-  return EMPTY;
+  return board.pieceOn(square);
 }
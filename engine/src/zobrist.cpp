@@ -26,4 +26,11 @@ Zobrist::Zobrist() {
 
   // Initialize the key for black to move
   blackToMoveKey = rng();
+
+  // Initialize material keys for each piece count
+  for (int piece = 0; piece < 12; piece++) {
+    for (int count = 0; count < 64; count++) {
+      materialKeys[piece][count] = rng();
+    }
+  }
 }
@@ -1,4 +1,5 @@
 #include "../include/board.hpp"
+#include "../include/utils.hpp"
 #include "test.hpp"
 
 bool test_board_initialization() {
@@ -23,10 +24,305 @@ bool test_board_initialization() {
   return true;
 }
 
+bool test_mailbox_tracks_moves() {
+  Board board("4k3/8/8/3p4/4P3/8/8/4K3 w - - 0 1");
+
+  ASSERT_EQ(WHITE_PAWN, board.pieceOn(E4));
+  ASSERT_EQ(BLACK_PAWN, board.pieceOn(D5));
+  ASSERT_EQ(EMPTY, board.pieceOn(E2));
+
+  // exd5 removes the black pawn and moves the white pawn
+  board.makeMove(Move(E4, D5, CAPTURE));
+  ASSERT_EQ(EMPTY, board.pieceOn(E4));
+  ASSERT_EQ(WHITE_PAWN, board.pieceOn(D5));
+
+  board.undoMove();
+  ASSERT_EQ(WHITE_PAWN, board.pieceOn(E4));
+  ASSERT_EQ(BLACK_PAWN, board.pieceOn(D5));
+
+  // Setters keep the mailbox in sync as well
+  board.setWhitePawns(0ULL);
+  ASSERT_EQ(EMPTY, board.pieceOn(E4));
+
+  return true;
+}
+
+bool test_undo_restores_state() {
+  Board board("r3k2r/8/8/8/8/8/8/R3K2R w KQkq - 0 1");
+  u64 startHash = board.getZobristHash();
+
+  // Rook takes rook: both sides lose their queen-side rights
+  board.makeMove(Move(A1, A8, CAPTURE));
+  ASSERT_EQ(WHITE_KS | BLACK_KS, board.getCastlingRights());
+  ASSERT_EQ(1, static_cast<int>(board.getMoveHistory().size()));
+
+  board.undoMove();
+  ASSERT_EQ(ALL_CASTLING, board.getCastlingRights());
+  ASSERT_EQ(BLACK_ROOK, board.pieceOn(A8));
+  ASSERT_EQ(startHash, board.getZobristHash());
+  ASSERT_TRUE(board.getMoveHistory().empty());
+
+  return true;
+}
+
+bool test_check_info_cached() {
+  // The e2 bishop is pinned by the e4 rook
+  Board board("4k3/8/8/8/4r3/8/4B3/4K3 w - - 0 1");
+  ASSERT_EQ(0ULL, board.getCheckers());
+  ASSERT_EQ(Utils::squareToBitboard(E2), board.getPinnedPieces(true));
+  ASSERT_EQ(Utils::squareToBitboard(E4), board.getPinners(BLACK));
+
+  // A rook on the open e-file gives check
+  Board check("4k3/8/8/8/4r3/8/8/4K3 w - - 0 1");
+  ASSERT_EQ(Utils::squareToBitboard(E4), check.getCheckers());
+  ASSERT_TRUE(check.isKingChecked(true));
+  ASSERT_EQ(1, check.getAttackersCount(true));
+
+  // After Kd1 a black rook on d4 would give check
+  check.makeMove(Move(E1, D1));
+  ASSERT_TRUE(check.getCheckSquares(ROOK) & Utils::squareToBitboard(D4));
+
+  return true;
+}
+
+bool test_null_move() {
+  Board board("4k3/8/8/3pP3/8/8/8/4K3 w - d6 0 1");
+  u64 startHash = board.getZobristHash();
+
+  board.makeNullMove();
+  ASSERT_TRUE(!board.getWhiteToMove());
+  ASSERT_EQ(SQ_NONE, board.getEnPassantSquare());
+  ASSERT_EQ(Board("4k3/8/8/3pP3/8/8/8/4K3 b - - 0 1").getZobristHash(),
+            board.getZobristHash());
+
+  board.undoNullMove();
+  ASSERT_TRUE(board.getWhiteToMove());
+  ASSERT_EQ(D6, board.getEnPassantSquare());
+  ASSERT_EQ(startHash, board.getZobristHash());
+
+  return true;
+}
+
+bool test_draw_detection() {
+  Board board;
+  Move shuffle[4] = {Move(G1, F3), Move(G8, F6), Move(F3, G1), Move(F6, G8)};
+
+  for (const Move &move : shuffle)
+    board.makeMove(move);
+  ASSERT_EQ(4, board.getHalfmoveClock());
+  ASSERT_EQ(3, board.getFullmoveNumber());
+
+  // One repetition is a draw inside the search but not in the game history
+  ASSERT_TRUE(board.isDraw(5));
+  ASSERT_TRUE(!board.isDraw(0));
+
+  for (const Move &move : shuffle)
+    board.makeMove(move);
+  ASSERT_TRUE(board.isDraw(0));
+
+  // A pawn move resets the clock and hides the earlier positions
+  board.makeMove(Move(E2, E4));
+  ASSERT_EQ(0, board.getHalfmoveClock());
+  ASSERT_TRUE(!board.isDraw(20));
+
+  Board fiftyMoves("4k3/8/8/8/8/8/8/4K2R w - - 100 80");
+  ASSERT_EQ(80, fiftyMoves.getFullmoveNumber());
+  ASSERT_TRUE(fiftyMoves.isDraw(0));
+
+  // Checkmate on the last reversible ply is not a draw; a check with an
+  // escape still is
+  Board mated("R6k/8/6K1/8/8/8/8/8 b - - 100 80");
+  ASSERT_TRUE(mated.inCheck());
+  ASSERT_TRUE(!mated.isDraw(0));
+  Board checked("R6k/8/8/8/8/8/8/6K1 b - - 100 80");
+  ASSERT_TRUE(checked.inCheck());
+  ASSERT_TRUE(checked.isDraw(0));
+
+  return true;
+}
+
+bool test_pawn_and_material_keys() {
+  Board board("r3k3/1P6/8/8/8/8/8/4K3 w - - 0 1");
+  u64 startPawnKey = board.getPawnKey();
+  u64 startMaterialKey = board.getMaterialKey();
+
+  // bxa8=Q removes both the pawn and the rook
+  board.makeMove(Move(B7, A8, QUEEN_PROMOTION_CAPTURE));
+  Board expected("Q3k3/8/8/8/8/8/8/4K3 b - - 0 1");
+  ASSERT_EQ(expected.getPawnKey(), board.getPawnKey());
+  ASSERT_EQ(expected.getMaterialKey(), board.getMaterialKey());
+  ASSERT_EQ(1, board.getPieceCount(WHITE_QUEEN));
+
+  // The material key ignores where the pieces stand
+  ASSERT_EQ(Board("4k3/8/8/8/8/8/8/Q3K3 w - - 0 1").getMaterialKey(),
+            board.getMaterialKey());
+
+  board.undoMove();
+  ASSERT_EQ(startPawnKey, board.getPawnKey());
+  ASSERT_EQ(startMaterialKey, board.getMaterialKey());
+
+  return true;
+}
+
+bool test_fen_round_trip() {
+  Board board;
+  char fen[MAX_FEN_LENGTH];
+
+  board.toFen(fen);
+  ASSERT_EQ(std::string("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w "
+                        "KQkq - 0 1"),
+            std::string(fen));
+
+  board.makeMove(Move(E2, E4));
+  int length = board.toFen(fen);
+  ASSERT_EQ(std::string("rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b "
+                        "KQkq e3 0 1"),
+            std::string(fen));
+  ASSERT_EQ(static_cast<int>(std::string(fen).size()), length);
+
+  const char *midgame = "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/"
+                        "1PP1QPPP/R4RK1 w - - 3 10";
+  Board parsed(midgame);
+  parsed.toFen(fen);
+  ASSERT_EQ(std::string(midgame), std::string(fen));
+
+  return true;
+}
+
+bool test_board_copies() {
+  Board board("r3k2r/8/8/8/8/8/8/R3K2R w KQkq - 0 1");
+  board.makeMove(Move(E1, G1, KING_CASTLE));
+
+  // Assignment copies the hash, the castled flags and the history
+  Board copy;
+  copy = board;
+  ASSERT_EQ(board.getZobristHash(), copy.getZobristHash());
+  ASSERT_TRUE(copy.getHasWhiteCastled());
+  copy.undoMove();
+  ASSERT_EQ(WHITE_KING, copy.pieceOn(E1));
+  ASSERT_TRUE(!copy.getHasWhiteCastled());
+
+  // A clone of the position alone plays on independently
+  Board clone(board.getPosition());
+  ASSERT_EQ(board.getZobristHash(), clone.getZobristHash());
+  ASSERT_EQ(0, clone.getHistoryPly());
+  clone.makeMove(Move(E8, C8, QUEEN_CASTLE));
+  ASSERT_EQ(BLACK_ROOK, clone.pieceOn(D8));
+  ASSERT_EQ(BLACK_ROOK, board.pieceOn(A8));
+
+  return true;
+}
+
+bool test_packed_position_round_trip() {
+  ASSERT_EQ(32u, sizeof(PackedPosition));
+
+  const char *fen =
+      "r3k2r/p1pp1pb1/bn2pnp1/2pPN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w Kq c6 3 17";
+  Board board(fen);
+  PackedPosition packed = board.encode();
+
+  Board decoded;
+  decoded.decode(packed);
+  char buffer[MAX_FEN_LENGTH];
+  decoded.toFen(buffer);
+  ASSERT_EQ(std::string(fen), std::string(buffer));
+  ASSERT_EQ(board.getZobristHash(), decoded.getZobristHash());
+  ASSERT_EQ(board.getPawnKey(), decoded.getPawnKey());
+  ASSERT_EQ(C6, decoded.getEnPassantSquare());
+
+  // Equal positions encode to equal bytes, different ones do not
+  ASSERT_TRUE(decoded.encode() == packed);
+  ASSERT_EQ(packed.hash(), decoded.encode().hash());
+  decoded.makeMove(Move(D5, C6, EN_PASSANT));
+  ASSERT_TRUE(!(decoded.encode() == packed));
+
+  return true;
+}
+
+bool test_move_encoding() {
+  ASSERT_EQ(2u, sizeof(Move));
+
+  Move promotion(B7, A8, QUEEN_PROMOTION_CAPTURE);
+  ASSERT_EQ(B7, promotion.getFromSquare());
+  ASSERT_EQ(A8, promotion.getToSquare());
+  ASSERT_TRUE(promotion.getIsCapture() && promotion.getIsPromotion());
+  ASSERT_EQ(WHITE_QUEEN, promotion.getPromotionPiece());
+  Move underPromotion(C2, C1, Move::promotionFlag(KNIGHT, false));
+  ASSERT_EQ(BLACK_KNIGHT, underPromotion.getPromotionPiece());
+  ASSERT_TRUE(Move(E1, G1, KING_CASTLE).isCastling());
+  ASSERT_TRUE(!(Move(E2, E4) == Move(E2, E4, CAPTURE)));
+
+  // The moving and captured pieces come from the board
+  Board board("4k3/8/8/3pP3/8/8/8/4K3 w - d6 0 1");
+  Move enPassant(E5, D6, EN_PASSANT);
+  ASSERT_EQ(WHITE_PAWN, board.movedPiece(enPassant));
+  ASSERT_EQ(BLACK_PAWN, board.capturedPiece(enPassant));
+  ASSERT_EQ(EMPTY, board.capturedPiece(Move(E1, E2)));
+
+  return true;
+}
+
+bool test_attackers_to() {
+  // Two black rooks attack the white king while black is to move
+  Board board("4r3/8/8/8/8/8/8/r3K2k b - - 0 1");
+  u64 rooks = Utils::squareToBitboard(E8) | Utils::squareToBitboard(A1);
+  ASSERT_EQ(rooks,
+            board.attackersTo(E1, board.getAllPieces()) &
+                board.getOccupancy(BLACK));
+  ASSERT_TRUE(board.isKingChecked(true));
+  ASSERT_EQ(2, board.getAttackersCount(true));
+  ASSERT_TRUE(!board.isKingChecked(false));
+
+  // Both sides' attackers are returned, and the occupancy decides blocking
+  Board start("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
+  ASSERT_EQ(Utils::squareToBitboard(G1) | Utils::squareToBitboard(E2) |
+                Utils::squareToBitboard(G2),
+            start.attackersTo(F3, start.getAllPieces()));
+  ASSERT_EQ(Utils::squareToBitboard(D1) | Utils::squareToBitboard(D8),
+            start.attackersTo(D4, Utils::squareToBitboard(D1) |
+                                      Utils::squareToBitboard(D8)));
+  return true;
+}
+
+bool test_long_game_history() {
+  // Knights shuffle far past the history cap; the board keeps working and
+  // recent moves can still be undone
+  Board board("4k1n1/8/8/8/8/8/8/4K1N1 w - - 0 1");
+  u64 startHash = board.getZobristHash();
+  const Move shuffle[4] = {Move(G1, F3), Move(G8, F6), Move(F3, G1),
+                           Move(F6, G8)};
+  for (int ply = 0; ply < 3 * STATE_STACK_SIZE; ply++)
+    board.makeMove(shuffle[ply % 4]);
+  ASSERT_LE(STATE_STACK_SIZE, board.getHistoryPly());
+  ASSERT_EQ(startHash, board.getZobristHash());
+
+  board.undoMove();
+  board.undoMove();
+  ASSERT_EQ(KNIGHT, kindOf(board.pieceOn(F3)));
+  ASSERT_EQ(KNIGHT, kindOf(board.pieceOn(F6)));
+
+  // Trimming leaves a search its full headroom
+  board.trimHistory();
+  ASSERT_LE(MAX_GAME_PLY, board.getHistoryPly());
+  return true;
+}
+
 int main() {
   std::cout << "Running Chess Engine Tests..." << std::endl;
 
   RUN_TEST(test_board_initialization);
+  RUN_TEST(test_mailbox_tracks_moves);
+  RUN_TEST(test_undo_restores_state);
+  RUN_TEST(test_check_info_cached);
+  RUN_TEST(test_null_move);
+  RUN_TEST(test_draw_detection);
+  RUN_TEST(test_pawn_and_material_keys);
+  RUN_TEST(test_fen_round_trip);
+  RUN_TEST(test_board_copies);
+  RUN_TEST(test_packed_position_round_trip);
+  RUN_TEST(test_move_encoding);
+  RUN_TEST(test_attackers_to);
+  RUN_TEST(test_long_game_history);
 
   std::cout << "Tests completed!" << std::endl;
   return 0;
@@ -147,7 +147,7 @@ bool test_king_legal_capture_undefended() {
   for (const Move &move : moves) {
     if (move.getToSquare() == Utils::bitboardToSquare(0x0000002000000000ULL)) {
       foundCapture = true;
-      ASSERT_TRUE(move.getCapturedPiece() != EMPTY);
+      ASSERT_TRUE(move.getIsCapture());
     }
   }
   ASSERT_TRUE(foundCapture);
@@ -571,6 +571,92 @@ bool test_queenside_castling_valid() {
   return true;
 }
 
+// Test: In double check only the king moves
+bool test_evasions_double_check() {
+  // Rook on A1 and knight on F3 both check the white king on E1
+  Board board("4k3/8/8/8/8/5n2/8/r3K2R w - - 0 1");
+
+  MoveList moves;
+  MoveGeneration::generateEvasions(board, moves);
+  ASSERT_EQ(2, moves.size()); // E2 and F2
+  for (Move move : moves)
+    ASSERT_EQ(E1, move.getFromSquare());
+  return true;
+}
+
+// Test: Evasions capture the checker, including along a pin line
+bool test_evasions_capture_checker() {
+  // The queen on E3 checks along the diagonal the bishop on C5 shares with
+  // the king and the black bishop on B6
+  Board board("4k3/8/1b6/2B5/8/4q3/8/6K1 w - - 0 1");
+
+  MoveList evasions;
+  MoveGeneration::generateEvasions(board, evasions);
+  ASSERT_TRUE(evasions.contains(Move(C5, E3, CAPTURE)));
+
+  MoveList all;
+  MoveGeneration::generateAllMoves(board, true, all);
+  ASSERT_EQ(all.size(), evasions.size());
+
+  // En passant removes a checking pawn
+  Board epBoard("8/8/8/2k5/3Pp3/8/8/4K3 b - d3 0 1");
+  MoveList epEvasions;
+  MoveGeneration::generateEvasions(epBoard, epEvasions);
+  ASSERT_TRUE(epEvasions.contains(Move(E4, D3, EN_PASSANT)));
+  return true;
+}
+
+bool test_quiet_checks() {
+  // The bishop on E2 uncovers the rook on E1 wherever it goes, and the knight
+  // checks directly from F6 or G7
+  Board board("4k3/8/8/7N/8/8/4B3/4R2K w - - 0 1");
+
+  MoveList checks;
+  MoveGeneration::generateQuietChecks(board, checks);
+  ASSERT_EQ(checks.size(), 10);
+  ASSERT_TRUE(checks.contains(Move(E2, A6)));
+  ASSERT_TRUE(checks.contains(Move(H5, F6)));
+  ASSERT_TRUE(checks.contains(Move(H5, G7)));
+  ASSERT_TRUE(!checks.contains(Move(H5, F4)));
+  ASSERT_TRUE(!checks.contains(Move(E1, D1)));
+  return true;
+}
+
+bool test_quiet_checks_castling() {
+  // Castling short puts the rook on F1, checking the king on F8; castling
+  // long leaves the rook on D1 and gives no check
+  Board board("5k2/8/8/8/8/8/8/R3K2R w KQ - 0 1");
+
+  MoveList checks;
+  MoveGeneration::generateQuietChecks(board, checks);
+  ASSERT_TRUE(checks.contains(Move(E1, G1, KING_CASTLE)));
+  ASSERT_TRUE(!checks.contains(Move(E1, C1, QUEEN_CASTLE)));
+  ASSERT_TRUE(checks.contains(Move(H1, F1)));
+  return true;
+}
+
+bool test_legal_captures_respect_pins() {
+  // The bishop on E2 is pinned by the rook on E8, so it may not take on C4
+  Board board("4r1k1/8/8/6p1/2n5/5N2/4B3/4K3 w - - 0 1");
+
+  MoveList captures;
+  MoveGeneration::generateLegalCaptures(board, captures);
+  ASSERT_TRUE(!captures.contains(Move(E2, C4, CAPTURE)));
+  ASSERT_TRUE(captures.contains(Move(F3, G5, CAPTURE)));
+
+  // Every legal capture is generated, and nothing else
+  MoveList all;
+  MoveGeneration::generateAllMoves(board, true, all);
+  int expected = 0;
+  for (Move move : all)
+    if (move.getIsCapture() || move.getIsPromotion()) {
+      ASSERT_TRUE(captures.contains(move));
+      expected++;
+    }
+  ASSERT_EQ(expected, captures.size());
+  return true;
+}
+
 int main() {
   std::cout << "Running Legal King Move Tests..." << std::endl;
 
@@ -599,6 +685,12 @@ int main() {
   RUN_TEST(test_castling_king_in_check);
   RUN_TEST(test_castling_through_attack);
   RUN_TEST(test_queenside_castling_valid);
+
+  RUN_TEST(test_evasions_double_check);
+  RUN_TEST(test_evasions_capture_checker);
+  RUN_TEST(test_quiet_checks);
+  RUN_TEST(test_quiet_checks_castling);
+  RUN_TEST(test_legal_captures_respect_pins);
   std::cout << "Tests completed!" << std::endl;
   return 0;
 }
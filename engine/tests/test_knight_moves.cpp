@@ -395,6 +395,18 @@ bool test_knight_pinned_diagonally() {
   return true;
 }
 
+// Test: The leaper attack tables agree with the setwise shift generators
+bool test_leaper_attack_tables() {
+  for (int sq = 0; sq < 64; sq++) {
+    u64 bb = Utils::squareToBitboard(sq);
+    ASSERT_EQ(validMoveBB::knightMoves(bb, 0ULL), Tables::KnightAttacks[sq]);
+    ASSERT_EQ(validMoveBB::kingMoves(bb, 0ULL), Tables::KingAttacks[sq]);
+    ASSERT_EQ(validMoveBB::whitePawnAttacks(bb), Tables::PawnAttacks[WHITE][sq]);
+    ASSERT_EQ(validMoveBB::blackPawnAttacks(bb), Tables::PawnAttacks[BLACK][sq]);
+  }
+  return true;
+}
+
 int main() {
   std::cout << "Running Knight Move Generation Tests..." << std::endl;
 
@@ -411,6 +423,7 @@ int main() {
   RUN_TEST(test_knight_pinned_horizontally);
   RUN_TEST(test_knight_pinned_vertically);
   RUN_TEST(test_knight_pinned_diagonally);
+  RUN_TEST(test_leaper_attack_tables);
 
   std::cout << "Knight tests completed!" << std::endl;
   return 0;
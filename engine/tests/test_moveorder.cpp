@@ -0,0 +1,118 @@
+#include "../include/board.hpp"
+#include "../include/evaluation.hpp"
+#include "../include/movegen.hpp"
+#include "../include/moveorder.hpp"
+#include "test.hpp"
+
+// Drains a picker, checking that it returns every legal move exactly once
+static bool picksAllLegalMoves(Board &board, Move ttMove,
+                               const Move *killers) {
+  MoveList legal;
+  MoveGeneration::generateAllMoves(board, board.getWhiteToMove(), legal);
+
+  MoveList picked;
+  MovePicker picker(board, ttMove, killers);
+  for (Move move = picker.next(); !move.isNull(); move = picker.next()) {
+    ASSERT_TRUE(legal.contains(move));
+    ASSERT_TRUE(!picked.contains(move));
+    picked.push_back(move);
+  }
+  ASSERT_EQ(legal.size(), picked.size());
+  return true;
+}
+
+// Test 1: Every stage together yields exactly the legal moves
+bool test_picker_covers_legal_moves() {
+  const char *fens[] = {
+      "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+      "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+      "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+      "4k3/8/8/8/8/8/4q3/4K3 w - - 0 1"};
+  for (const char *fen : fens) {
+    Board board(fen);
+    if (!picksAllLegalMoves(board, Move(), nullptr))
+      return false;
+  }
+  return true;
+}
+
+// Test 2: The TT move comes first, then good captures, then killers
+bool test_picker_stage_order() {
+  // White can take the queen with the pawn or play quiet moves
+  Board board("4k3/8/8/3q4/4P3/8/8/R3K3 w - - 0 1");
+  Move ttMove(A1, A7);
+  Move killers[2] = {Move(E1, F2), Move(A1, A2)};
+
+  MovePicker picker(board, ttMove, killers);
+  ASSERT_TRUE(picker.next() == ttMove);
+  ASSERT_TRUE(picker.next() == Move(E4, D5, CAPTURE));
+  ASSERT_TRUE(picker.next() == killers[0]);
+  ASSERT_TRUE(picker.next() == killers[1]);
+
+  return picksAllLegalMoves(board, ttMove, killers);
+}
+
+// Test 3: Illegal TT and killer moves are never returned
+bool test_picker_rejects_illegal_moves() {
+  // The white king is in check from the rook on e8
+  Board board("4r1k1/8/8/8/8/8/3P4/R3K3 w Q - 0 1");
+  Move castle(E1, C1, QUEEN_CASTLE);
+  Move pawnPush(D2, D3);
+  Move killers[2] = {pawnPush, Move(B1, B2)};
+
+  ASSERT_TRUE(!MoveGeneration::isLegal(board, castle));
+  ASSERT_TRUE(!MoveGeneration::isLegal(board, pawnPush));
+  ASSERT_TRUE(MoveGeneration::isLegal(board, Move(E1, F2)));
+
+  return picksAllLegalMoves(board, castle, killers);
+}
+
+// Test 4: Only captures of defended pieces wait until after the quiet moves
+bool test_picker_defers_defended_captures() {
+  // The pawn on h7 is free for the queen; the rook on b1 would be taken back
+  // after capturing on b5
+  Board board("4k3/7p/p7/1p6/8/8/8/1R2K2Q w - - 0 1");
+  Move killers[2] = {Move(E1, D2), Move(E1, F2)};
+
+  MovePicker picker(board, Move(), killers);
+  ASSERT_TRUE(picker.next() == Move(H1, H7, CAPTURE));
+  ASSERT_TRUE(picker.next() == killers[0]);
+  ASSERT_TRUE(picker.next() == killers[1]);
+
+  Move last;
+  for (Move move = picker.next(); !move.isNull(); move = picker.next())
+    last = move;
+  ASSERT_TRUE(last == Move(B1, B5, CAPTURE));
+
+  return picksAllLegalMoves(board, Move(), killers);
+}
+
+// Test 5: Quiet promotions in the capture list are scored without a victim
+bool test_order_captures_quiet_promotions() {
+  Board board("4k3/1P6/8/8/8/8/8/4K3 w - - 0 1");
+  MoveList captures;
+  MoveGeneration::generateLegalCaptures(board, captures);
+  ASSERT_EQ(4, captures.size());
+
+  MoveOrder::orderCaptures(board, captures);
+  ASSERT_EQ(4, captures.size());
+  for (Move move : captures) {
+    ASSERT_TRUE(move.getIsPromotion());
+    ASSERT_EQ(-Evaluation::materialValue[PAWN],
+              MoveOrder::getCaptureScore(board, move));
+  }
+  return true;
+}
+
+int main() {
+  std::cout << "Running Move Ordering Tests..." << std::endl;
+
+  RUN_TEST(test_picker_covers_legal_moves);
+  RUN_TEST(test_picker_stage_order);
+  RUN_TEST(test_picker_rejects_illegal_moves);
+  RUN_TEST(test_picker_defers_defended_captures);
+  RUN_TEST(test_order_captures_quiet_promotions);
+
+  std::cout << "Move ordering tests completed!" << std::endl;
+  return 0;
+}
@@ -526,6 +526,26 @@ bool test_black_en_passant_valid() {
   return true;
 }
 
+// Test: Color-templated pawn helpers mirror each other
+bool test_pawn_templates_by_color() {
+  u64 e4 = Utils::squareToBitboard(E4);
+  u64 a2 = Utils::squareToBitboard(A2);
+  ASSERT_EQ(Utils::squareToBitboard(D5) | Utils::squareToBitboard(F5),
+            validMoveBB::pawnAttacks<WHITE>(e4));
+  ASSERT_EQ(Utils::squareToBitboard(D3) | Utils::squareToBitboard(F3),
+            validMoveBB::pawnAttacks<BLACK>(e4));
+  ASSERT_EQ(Utils::squareToBitboard(B3), validMoveBB::pawnAttacks<WHITE>(a2));
+
+  // Double pushes only from the starting rank, captures only onto enemies
+  u64 e7 = Utils::squareToBitboard(E7);
+  u64 enemy = Utils::squareToBitboard(D6);
+  ASSERT_EQ(Utils::squareToBitboard(E6) | Utils::squareToBitboard(E5) | enemy,
+            validMoveBB::pawnMoves<BLACK>(e7, enemy, enemy));
+  ASSERT_EQ(Utils::squareToBitboard(E5),
+            validMoveBB::pawnMoves<WHITE>(e4, 0ULL, 0ULL));
+  return true;
+}
+
 int main() {
   std::cout << "Running Pawn Move Generation Tests..." << std::endl;
 
@@ -551,6 +571,7 @@ int main() {
   RUN_TEST(test_black_en_passant_valid);
   RUN_TEST(test_no_en_passant_single_move);
   RUN_TEST(test_no_en_passant_no_adjacent);
+  RUN_TEST(test_pawn_templates_by_color);
 
   std::cout << "Pawn tests completed!" << std::endl;
   return 0;
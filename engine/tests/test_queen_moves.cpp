@@ -211,6 +211,58 @@ bool test_queen_pinned_diagonally() {
   return true;
 }
 
+// Squares attacked from 'sq' along (df, dr) steps, stopping at a blocker
+static u64 walkRay(int sq, int df, int dr, u64 occupied) {
+  u64 attacks = 0ULL;
+  int file = sq % 8 + df, rank = sq / 8 + dr;
+  for (; file >= 0 && file < 8 && rank >= 0 && rank < 8;
+       file += df, rank += dr) {
+    u64 bb = Utils::squareToBitboard(rank * 8 + file);
+    attacks |= bb;
+    if (occupied & bb)
+      break;
+  }
+  return attacks;
+}
+
+// Test: Both slider attack implementations match a square-by-square walk
+bool test_slider_attacks_match_lookups() {
+  u64 seed = 0x9E3779B97F4A7C15ULL;
+  auto next = [&seed]() {
+    seed ^= seed << 13;
+    seed ^= seed >> 7;
+    seed ^= seed << 17;
+    return seed;
+  };
+
+  bool avx2 = validMoveBB::hasAvx2SliderAttacks();
+  for (int i = 0; i < 10000; i++) {
+    u64 occupied = next() & next();
+    u64 diagonal = occupied & next() & next();
+    u64 straight = occupied & next() & next();
+
+    u64 expected = 0ULL;
+    for (u64 bb = diagonal; bb;) {
+      int sq = Utils::popLSB(bb);
+      expected |= walkRay(sq, 1, 1, occupied) | walkRay(sq, -1, 1, occupied) |
+                  walkRay(sq, 1, -1, occupied) | walkRay(sq, -1, -1, occupied);
+    }
+    for (u64 bb = straight; bb;) {
+      int sq = Utils::popLSB(bb);
+      expected |= walkRay(sq, 0, 1, occupied) | walkRay(sq, 0, -1, occupied) |
+                  walkRay(sq, 1, 0, occupied) | walkRay(sq, -1, 0, occupied);
+    }
+    ASSERT_EQ(expected,
+              validMoveBB::sliderAttacksScalar(diagonal, straight, occupied));
+    if (avx2)
+      ASSERT_EQ(expected,
+                validMoveBB::sliderAttacksAvx2(diagonal, straight, occupied));
+    ASSERT_EQ(expected,
+              validMoveBB::sliderAttacks(diagonal, straight, occupied));
+  }
+  return true;
+}
+
 int main() {
   std::cout << "Running Queen Move Generation Tests..." << std::endl;
   RUN_TEST(test_white_queen_center_empty);
@@ -223,6 +275,7 @@ int main() {
   RUN_TEST(test_queen_pinned_horizontally);
   RUN_TEST(test_queen_pinned_vertically);
   RUN_TEST(test_queen_pinned_diagonally);
+  RUN_TEST(test_slider_attacks_match_lookups);
 
   std::cout << "Queen tests completed!" << std::endl;
   return 0;
@@ -1,5 +1,4 @@
 #include "../include/board.hpp"
-#include "../include/magic.hpp"
 #include "../include/movegen.hpp"
 #include "../include/utils.hpp"
 #include "test.hpp"
@@ -170,10 +169,7 @@ bool test_rook_pinned_diagonally() {
   board.setBlackQueens(0ULL);
   board.setBlackKing(0x8000000000000000ULL); // H8
   board.setALLPiecesAggregate();
-  bool isChecked = board.isKingChecked(true);
-  u64 pinned = board.getPinnedPieces(true);
-  std::vector<Move> moves =
-      MoveGeneration::generateRookLegalMoves(board, true, isChecked, pinned);
+  std::vector<Move> moves = MoveGeneration::generateRookLegalMoves(board, true);
   // Diagonally pinned rook should have 0 legal moves
   ASSERT_EQ(0, moves.size());
   return true;
@@ -194,11 +190,7 @@ bool test_rook_pinned_horizontally_by_rook() {
   board.setBlackQueens(0ULL);
   board.setBlackKing(0x8000000000000000ULL); // H8
   board.setALLPiecesAggregate();
-  bool isChecked = board.isKingChecked(true);
-  u64 pinned = board.getPinnedPieces(true);
-
-  std::vector<Move> moves =
-      MoveGeneration::generateRookLegalMoves(board, true, isChecked, pinned);
+  std::vector<Move> moves = MoveGeneration::generateRookLegalMoves(board, true);
   ASSERT_EQ(2, moves.size());
 
   return true;
@@ -219,18 +211,13 @@ bool test_rook_pinned_vertically_by_queen() {
   board.setBlackQueens(0x0000100000000000ULL); // E6 - pinning queen
   board.setBlackKing(0x8000000000000000ULL);   // H8
   board.setALLPiecesAggregate();
-  bool isChecked = board.isKingChecked(true);
-  u64 pinned = board.getPinnedPieces(true);
-
-  std::vector<Move> moves =
-      MoveGeneration::generateRookLegalMoves(board, true, isChecked, pinned);
+  std::vector<Move> moves = MoveGeneration::generateRookLegalMoves(board, true);
   ASSERT_EQ(3, moves.size());
 
   return true;
 }
 
 int main() {
-  Magic::initMagics();
   std::cout << "Running Rook Move Generation Tests..." << std::endl;
   RUN_TEST(test_white_rook_center_empty);
   RUN_TEST(test_black_rook_blocked_own);